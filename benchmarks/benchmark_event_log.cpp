@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+#include "EventLog.h"
+#include "ExecutionReport.h"
+#include "TradeLogSink.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+// Cost on the matching thread of logging one trade: the binary event log
+// (copy into the ring; a background thread does the writing) against the
+// simulator's former text log (format through std::ostream into a file).
+
+static const char* const EventLogPath = "/tmp/orderbook-bench.events";
+static const char* const TextLogPath = "/tmp/orderbook-bench-log.txt";
+
+static Trade tradeFor(long long i) { return Trade(i, i + 1, Price(10000LL + i % 100), 1 + static_cast<int>(i % 100), 1000000LL + i * 100); }
+
+static void BM_TradeLog_BinaryRing(benchmark::State& state) {
+  EventLogWriter log(EventLogPath);
+  ReportSink<LogReports> sink(LogReports{&log});
+  long long i = 0;
+
+  for (auto _ : state) {
+    sink.onTrade(tradeFor(i++));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["stalls"] = static_cast<double>(log.stalls());
+  log.close();
+  std::remove(EventLogPath);
+}
+BENCHMARK(BM_TradeLog_BinaryRing);
+
+static void BM_TradeLog_Iostream(benchmark::State& state) {
+  std::ofstream file(TextLogPath);
+  TradeLogSink sink(file);
+  long long i = 0;
+
+  for (auto _ : state) {
+    sink.onTrade(tradeFor(i++));
+  }
+  state.SetItemsProcessed(state.iterations());
+  file.close();
+  std::remove(TextLogPath);
+}
+BENCHMARK(BM_TradeLog_Iostream);
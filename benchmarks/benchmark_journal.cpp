@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+#include "Journal.h"
+#include "OrderBook.h"
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// The simulator's workload: 40% adds drifting around 100.00, 30% cancels
+// and 30% amends of live orders.
+static std::vector<Command> simulatorCommands(int count) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<> chance(0.0, 1.0);
+  std::uniform_int_distribution<> drift(-50, 50);
+  std::uniform_int_distribution<> reprice(-100, 100);
+  std::vector<Command> commands;
+  commands.reserve(count);
+  std::vector<int> live;
+  long long mid = 10000;
+  int nextId = 1;
+
+  for (int i = 0; i < count; ++i) {
+    double r = chance(gen);
+    Command command;
+    if (!live.empty() && r < 0.3) {
+      command = Command::modify(live[gen() % live.size()], Price(mid + reprice(gen)), 1 + gen() % 100);
+    } else if (!live.empty() && r < 0.6) {
+      size_t idx = gen() % live.size();
+      command = Command::cancel(live[idx]);
+      live[idx] = live.back();
+      live.pop_back();
+    } else {
+      mid += drift(gen);
+      command = Command::add(nextId, Price(mid), 1 + gen() % 100, gen() % 2 == 0, gen() % 100000);
+      live.push_back(nextId++);
+    }
+    command.timestamp = 1000000LL + i * 100LL;
+    commands.push_back(command);
+  }
+  return commands;
+}
+
+// Journals are written once per size, reused across runs and removed at exit.
+struct JournalFiles {
+  std::map<int, std::string> paths;
+  ~JournalFiles() {
+    for (auto& entry : paths) std::remove(entry.second.c_str());
+  }
+};
+
+static const std::string& journalFor(int count) {
+  static JournalFiles files;
+  std::map<int, std::string>& paths = files.paths;
+  auto it = paths.find(count);
+  if (it != paths.end()) return it->second;
+
+  std::string path = "/tmp/orderbook-bench-" + std::to_string(count) + ".journal";
+  JournalWriter::Config config;
+  config.sync = false;
+  JournalWriter writer(path, config);
+  for (const Command& command : simulatorCommands(count)) writer.append(command);
+  return paths.emplace(count, path).first->second;
+}
+
+static void BM_Journal_Append(benchmark::State& state) {
+  const std::string path = "/tmp/orderbook-bench-append.journal";
+  std::vector<Command> commands = simulatorCommands(100000);
+  JournalWriter::Config config;
+  config.sync = state.range(0) != 0;
+  config.groupCommit = 1024;
+
+  for (auto _ : state) {
+    JournalWriter writer(path, config);
+    for (const Command& command : commands) writer.append(command);
+  }
+  state.SetItemsProcessed(state.iterations() * commands.size());
+  state.SetBytesProcessed(state.iterations() * commands.size() * sizeof(JournalRecord));
+  std::remove(path.c_str());
+}
+BENCHMARK(BM_Journal_Append)->ArgName("sync")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+// Recovery time: map the journal and stream it into an empty book.
+static void BM_Journal_Recovery(benchmark::State& state) {
+  const std::string& path = journalFor(state.range(0));
+
+  for (auto _ : state) {
+    auto book = std::make_unique<OrderBook>();
+    NullSink sink;
+    JournalReader reader(path);
+    benchmark::DoNotOptimize(replayJournal(reader, *book, sink));
+
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Journal_Recovery)->ArgName("commands")->Arg(1000000)->Arg(10000000)
+  ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// A book of `orders` resting orders, half a side, spread over 5000 levels
+// per side so no two orders cross.
+static std::unique_ptr<OrderBook> restingBook(int orders) {
+  auto book = std::make_unique<OrderBook>();
+  NullSink sink;
+  for (int i = 0; i < orders; ++i) {
+    bool isBuy = i % 2 == 0;
+    long long offset = 1 + (i / 2) % 5000;
+    book->addOrder(i, Price(isBuy ? 10000 - offset : 10000 + offset), 10, isBuy, i % 1000, orderType::GTC, sink);
+  }
+  return book;
+}
+
+static void BM_Snapshot_Save(benchmark::State& state) {
+  auto book = restingBook(state.range(0));
+  std::vector<char> image;
+  for (auto _ : state) {
+    image.clear();
+    book->saveSnapshot(image);
+    benchmark::DoNotOptimize(image.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * image.size());
+}
+BENCHMARK(BM_Snapshot_Save)->ArgName("orders")->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Bulk restore against the same orders re-added one by one through addOrder.
+static void BM_Snapshot_Restore(benchmark::State& state) {
+  std::vector<char> image;
+  restingBook(state.range(0))->saveSnapshot(image);
+
+  for (auto _ : state) {
+    auto book = std::make_unique<OrderBook>();
+    book->restoreSnapshot(image.data(), image.size());
+
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Snapshot_Restore)->ArgName("orders")->Arg(1000000)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_Snapshot_RestoreViaAddOrder(benchmark::State& state) {
+  for (auto _ : state) {
+    auto book = restingBook(state.range(0));
+
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Snapshot_RestoreViaAddOrder)->ArgName("orders")->Arg(1000000)->UseRealTime()->Unit(benchmark::kMillisecond);
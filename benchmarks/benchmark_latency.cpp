@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+#include "Clock.h"
+#include "Command.h"
+#include "Journal.h"
+#include "LatencyHistogram.h"
+#include "OrderBook.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Workload-driven latency harness. Every command of an order stream is
+// timed individually with the cycle counter and recorded into a histogram
+// for its kind (add, cancel, modify, or an add that traded: match), and the
+// tail percentiles are reported as benchmark counters next to the sustained
+// items_per_second.
+//
+// The stream is the simulator's random walk (src/main.cpp) by default. Set
+// ORDERBOOK_BENCH_JOURNAL to a journal recorded by the simulator to replay
+// real flow instead.
+
+// Cycle-counter ticks per nanosecond, measured once against steady_clock.
+static double ticksPerNanosecond() {
+  static const double rate = [] {
+    TscClock tsc;
+    auto start = std::chrono::steady_clock::now();
+    long long ticks = tsc.now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    long long elapsedTicks = tsc.now() - ticks;
+    long long elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(elapsedTicks) / elapsedNs;
+  }();
+  return rate;
+}
+
+// Same mix as the simulator: 30% amends, 30% cancels of live orders and 40%
+// adds around a mid that drifts by up to 50 cents per add.
+static std::vector<Command> simulatorStream(int count) {
+  std::mt19937 gen(2024);
+  std::uniform_real_distribution<> chance(0.0, 1.0);
+  std::uniform_real_distribution<> priceMove(-0.50, 0.50);
+  std::uniform_real_distribution<> newPriceMove(-1.0, 1.0);
+  std::uniform_int_distribution<> qty(1, 100);
+  std::uniform_int_distribution<> user(1, 100000000);
+
+  std::vector<Command> commands;
+  commands.reserve(count);
+  std::vector<int> live;
+  double currentPrice = 100.00;
+  int nextId = 1;
+
+  for (int i = 0; i < count; ++i) {
+    double r = chance(gen);
+    if (!live.empty() && r < 0.3) {
+      int id = live[gen() % live.size()];
+      commands.push_back(Command::modify(id, std::round((currentPrice + newPriceMove(gen)) * 100.0) / 100.0, qty(gen)));
+    } else if (!live.empty() && r < 0.6) {
+      size_t idx = gen() % live.size();
+      commands.push_back(Command::cancel(live[idx]));
+      live[idx] = live.back();
+      live.pop_back();
+    } else {
+      currentPrice = std::round((currentPrice + priceMove(gen)) * 100.0) / 100.0;
+      commands.push_back(Command::add(nextId, currentPrice, qty(gen), gen() % 2 == 0, user(gen)));
+      live.push_back(nextId++);
+    }
+  }
+  return commands;
+}
+
+static const std::vector<Command>& orderStream() {
+  static const std::vector<Command> stream = [] {
+    if (const char* path = std::getenv("ORDERBOOK_BENCH_JOURNAL")) {
+      JournalReader journal(path);
+      std::vector<Command> recorded;
+      recorded.reserve(journal.size());
+      for (const JournalRecord& record : journal) recorded.push_back(record.command);
+      return recorded;
+    }
+    return simulatorStream(1000000);
+  }();
+  return stream;
+}
+
+class TradeCounter : public ExecutionSink {
+public:
+  long long trades = 0;
+  void onTrade(const Trade&) override { ++trades; }
+};
+
+enum OperationKind { AddKind, CancelKind, ModifyKind, MatchKind, KindCount };
+static const char* const KindNames[KindCount] = {"add", "cancel", "modify", "match"};
+
+static void reportPercentiles(benchmark::State& state, const std::string& prefix, const LatencyHistogram& histogram) {
+  state.counters[prefix + "p50_ns"] = histogram.percentile(50.0);
+  state.counters[prefix + "p99_ns"] = histogram.percentile(99.0);
+  state.counters[prefix + "p999_ns"] = histogram.percentile(99.9);
+  state.counters[prefix + "max_ns"] = histogram.max();
+}
+
+// One benchmark iteration is one command; the book is rebuilt (untimed)
+// whenever the stream wraps around.
+static void BM_OrderFlow_Throughput(benchmark::State& state) {
+  const std::vector<Command>& stream = orderStream();
+  const double rate = ticksPerNanosecond();
+  const bool ladder = state.range(0) != 0;
+  auto makeBook = [ladder] {
+    return ladder ? std::make_unique<OrderBook>(LadderConfig{50.0, 200.0, 1}) : std::make_unique<OrderBook>();
+  };
+
+  std::unique_ptr<OrderBook> book = makeBook();
+  TscClock tsc;
+  TradeCounter sink;
+  LatencyHistogram histograms[KindCount];
+  size_t position = 0;
+
+  for (auto _ : state) {
+    if (position == stream.size()) {
+      state.PauseTiming();
+      book = makeBook();
+      position = 0;
+      state.ResumeTiming();
+    }
+    const Command& command = stream[position++];
+    long long tradesBefore = sink.trades;
+
+    long long start = tsc.now();
+    book->apply(command, sink);
+    long long elapsed = tsc.now() - start;
+
+    OperationKind kind = command.type == CommandType::Cancel ? CancelKind
+                       : command.type == CommandType::Modify ? ModifyKind
+                       : sink.trades != tradesBefore ? MatchKind : AddKind;
+    histograms[kind].record(static_cast<long long>(elapsed / rate));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  LatencyHistogram all;
+  for (int kind = 0; kind < KindCount; ++kind) {
+    all.merge(histograms[kind]);
+    if (histograms[kind].count()) reportPercentiles(state, std::string(KindNames[kind]) + "_", histograms[kind]);
+  }
+  reportPercentiles(state, "", all);
+}
+BENCHMARK(BM_OrderFlow_Throughput)->ArgName("ladder")->Arg(0)->Arg(1)->Iterations(2000000)->UseRealTime();
@@ -0,0 +1,190 @@
+#include <benchmark/benchmark.h>
+#include "MatchingEngine.h"
+#include "MatchingThread.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+static long long steadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Each producer runs its own add/cancel random walk around 100.00 with a
+// private id range, 60% adds and 40% cancels of its own live orders.
+static void produce(MatchingThread& engine, int producer, int commands) {
+  std::mt19937 gen(producer + 1);
+  std::uniform_real_distribution<> chance(0.0, 1.0);
+  std::uniform_int_distribution<> tick(-50, 50);
+  std::vector<int> live;
+  int nextId = producer * 100000000;
+
+  for (int i = 0; i < commands; ++i) {
+    Command command;
+    if (!live.empty() && chance(gen) < 0.4) {
+      size_t idx = gen() % live.size();
+      command = Command::cancel(live[idx]);
+      live[idx] = live.back();
+      live.pop_back();
+    } else {
+      command = Command::add(nextId, Price(10000LL + tick(gen)), 10, chance(gen) < 0.5, producer * 1000 + gen() % 1000);
+      live.push_back(nextId++);
+    }
+    command.timestamp = steadyNanos();
+
+    unsigned spins = 0;
+    while (!engine.submit(producer, command)) idleSpin(spins);
+  }
+}
+
+static void BM_MatchingThread_Throughput(benchmark::State& state) {
+  int producers = state.range(0);
+  int perProducer = 200000 / producers;
+  long long total = static_cast<long long>(perProducer) * producers;
+  std::vector<long long> latencies;
+  latencies.reserve(total);
+
+  for (auto _ : state) {
+    MatchingThread::Config config;
+    config.producers = producers;
+    MatchingThread engine(config);
+    engine.start();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) threads.emplace_back(produce, std::ref(engine), p, perProducer);
+
+    // Ingress-to-report latency, sampled on the acceptance of each add.
+    ExecutionReport reports[256];
+    unsigned spins = 0;
+    while (true) {
+      size_t n = engine.pollBatch(reports, 256);
+      long long now = steadyNanos();
+      for (size_t i = 0; i < n; ++i) {
+        if (reports[i].type == ReportType::Accepted) latencies.push_back(now - reports[i].timestamp);
+      }
+      if (!n) {
+        if (engine.processed() >= static_cast<unsigned long long>(total)) break;
+        idleSpin(spins);
+      }
+    }
+
+    for (auto& thread : threads) thread.join();
+    engine.stop();
+    while (engine.pollBatch(reports, 256)) {}
+  }
+
+  state.SetItemsProcessed(state.iterations() * total);
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    state.counters["p50_ns"] = latencies[latencies.size() / 2];
+    state.counters["p99_ns"] = latencies[latencies.size() * 99 / 100];
+  }
+}
+BENCHMARK(BM_MatchingThread_Throughput)->ArgName("producers")->Arg(1)->Arg(2)->Arg(4)
+  ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Single-threaded reference: the same stream applied directly to a book.
+static void BM_DirectApply_Throughput(benchmark::State& state) {
+  const int total = 200000;
+  std::vector<Command> commands;
+  commands.reserve(total);
+  {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<> chance(0.0, 1.0);
+    std::uniform_int_distribution<> tick(-50, 50);
+    std::vector<int> live;
+    int nextId = 0;
+    for (int i = 0; i < total; ++i) {
+      if (!live.empty() && chance(gen) < 0.4) {
+        size_t idx = gen() % live.size();
+        commands.push_back(Command::cancel(live[idx]));
+        live[idx] = live.back();
+        live.pop_back();
+      } else {
+        commands.push_back(Command::add(nextId, Price(10000LL + tick(gen)), 10, chance(gen) < 0.5, gen() % 1000));
+        live.push_back(nextId++);
+      }
+    }
+  }
+
+  for (auto _ : state) {
+    OrderBook book;
+    NullSink sink;
+    for (const Command& command : commands) book.apply(command, sink);
+    benchmark::DoNotOptimize(book);
+  }
+  state.SetItemsProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_DirectApply_Throughput)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Multi-instrument scaling: one producer per shard, each running the same
+// add/cancel walk spread over 1000 instruments. Ids are interleaved across
+// producers so the whole run fits the directory's dense range, and cancels
+// are routed through it.
+static void produceMulti(MatchingEngine& engine, int producer, int producers, int commands) {
+  const uint32_t instruments = 1000;
+  std::mt19937 gen(producer + 1);
+  std::uniform_real_distribution<> chance(0.0, 1.0);
+  std::uniform_int_distribution<> tick(-50, 50);
+  std::vector<int> live;
+  int nextId = producer;
+
+  for (int i = 0; i < commands; ++i) {
+    Command command;
+    if (!live.empty() && chance(gen) < 0.4) {
+      size_t idx = gen() % live.size();
+      command = Command::cancel(live[idx]);
+      live[idx] = live.back();
+      live.pop_back();
+    } else {
+      command = Command::add(nextId, Price(10000LL + tick(gen)), 10, chance(gen) < 0.5, producer * 1000 + gen() % 1000);
+      command.instrument = gen() % instruments;
+      live.push_back(nextId);
+      nextId += producers;
+    }
+    command.timestamp = steadyNanos();
+
+    unsigned spins = 0;
+    while (!engine.submit(producer, command)) idleSpin(spins);
+  }
+}
+
+static void BM_MatchingEngine_Throughput(benchmark::State& state) {
+  int shards = state.range(0);
+  int perProducer = 400000 / shards;
+  long long total = static_cast<long long>(perProducer) * shards;
+
+  for (auto _ : state) {
+    MatchingEngine::Config config;
+    config.shards = shards;
+    config.producers = shards;
+    config.directoryCapacity = total;
+    MatchingEngine engine(config);
+    for (uint32_t instrument = 0; instrument < 1000; ++instrument) engine.addInstrument(instrument);
+    engine.start();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < shards; ++p) threads.emplace_back(produceMulti, std::ref(engine), p, shards, perProducer);
+
+    ExecutionReport reports[256];
+    unsigned spins = 0;
+    while (true) {
+      if (engine.pollBatch(reports, 256)) {
+        spins = 0;
+        continue;
+      }
+      if (engine.processed() >= static_cast<unsigned long long>(total)) break;
+      idleSpin(spins);
+    }
+
+    for (auto& thread : threads) thread.join();
+    engine.stop();
+    while (engine.pollBatch(reports, 256)) {}
+  }
+
+  state.SetItemsProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_MatchingEngine_Throughput)->ArgName("shards")->Arg(1)->Arg(2)->Arg(4)->Arg(8)
+  ->UseRealTime()->Unit(benchmark::kMillisecond);
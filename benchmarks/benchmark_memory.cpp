@@ -0,0 +1,184 @@
+#include <benchmark/benchmark.h>
+#include "OrderBook.h"
+#include "ExecutionSink.h"
+#include "Trade.h"
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <vector>
+
+// Live heap bytes, tracked through the global allocation functions so the
+// report covers every container the book uses internally. This file is its
+// own executable, so no other benchmark runs under the counting allocator.
+static std::atomic<long long> liveBytes{0};
+
+// Each block is preceded by a header holding its requested size, so every
+// delete overload, sized or not, takes back exactly what new added.
+static size_t headerFor(size_t align) { return align > alignof(std::max_align_t) ? align : alignof(std::max_align_t); }
+
+static void* countedAllocate(size_t size, size_t align) {
+  size_t header = headerFor(align);
+  size_t total = (header + size + align - 1) / align * align;
+  void* base = align > alignof(std::max_align_t) ? std::aligned_alloc(align, total) : std::malloc(total);
+  if (!base) throw std::bad_alloc();
+  char* ptr = static_cast<char*>(base) + header;
+  reinterpret_cast<size_t*>(ptr)[-1] = size;
+  liveBytes += static_cast<long long>(size);
+  return ptr;
+}
+
+static void countedRelease(void* ptr, size_t align) noexcept {
+  if (!ptr) return;
+  liveBytes -= static_cast<long long>(reinterpret_cast<size_t*>(ptr)[-1]);
+  std::free(static_cast<char*>(ptr) - headerFor(align));
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { countedRelease(ptr, alignof(std::max_align_t)); }
+void operator delete(void* ptr, std::size_t) noexcept { countedRelease(ptr, alignof(std::max_align_t)); }
+void operator delete(void* ptr, std::align_val_t alignment) noexcept { countedRelease(ptr, static_cast<size_t>(alignment)); }
+void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {
+  countedRelease(ptr, static_cast<size_t>(alignment));
+}
+
+static void BM_Memory_PerRestingOrder(benchmark::State& state) {
+  int numOrders = state.range(0);
+  double bytesPerOrder = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    long long before = liveBytes;
+    auto book = std::make_unique<OrderBook>();
+    std::vector<Trade> trades;
+    long long overhead = liveBytes - before;
+    state.ResumeTiming();
+
+    // Ten orders per level, bids only, so nothing matches.
+    for (int i = 0; i < numOrders; ++i) {
+      book->addOrder(i, 100.0 - (i / 10) * 0.01, 10, true, 1000 + i, orderType::GTC, trades);
+    }
+
+    state.PauseTiming();
+    bytesPerOrder = static_cast<double>(liveBytes - before - overhead) / numOrders;
+    book.reset();
+    state.ResumeTiming();
+  }
+  state.counters["bytes_per_order"] = bytesPerOrder;
+  // Of which the order record the match loop reads, and the cold remainder.
+  state.counters["hot_bytes"] = sizeof(Order);
+  state.counters["cold_bytes"] = sizeof(OrderDetails);
+}
+BENCHMARK(BM_Memory_PerRestingOrder)->RangeMultiplier(10)->Range(1000, 1000000)->Unit(benchmark::kMillisecond);
+
+// The 30/30/40 modify/cancel/add random walk from src/main.cpp.
+template <typename Output>
+static void runRandomWalk(benchmark::State& state, OrderBook& book, Output& output) {
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<> chance(0.0, 1.0);
+  std::uniform_real_distribution<> priceMove(-0.50, 0.50);
+  std::uniform_int_distribution<> qtyGen(1, 100);
+  std::vector<int> idVec;
+  double currentPrice = 100.0;
+  int nextOrderId = 1;
+
+  for (auto _ : state) {
+    double r = chance(gen);
+    if (!idVec.empty() && r < 0.3) {
+      int id = idVec[gen() % idVec.size()];
+      book.modifyOrder(id, std::round((currentPrice + priceMove(gen)) * 100.0) / 100.0, qtyGen(gen), output);
+    } else if (!idVec.empty() && r < 0.6) {
+      size_t idx = gen() % idVec.size();
+      book.cancelOrder(idVec[idx]);
+      idVec[idx] = idVec.back();
+      idVec.pop_back();
+    } else {
+      currentPrice = std::round((currentPrice + priceMove(gen)) * 100.0) / 100.0;
+      book.addOrder(nextOrderId, currentPrice, qtyGen(gen), chance(gen) < 0.5, gen(), orderType::GTC, output);
+      idVec.push_back(nextOrderId++);
+    }
+  }
+}
+
+// Heap policy (0) or the default pool policy (1).
+static void BM_Allocation_RandomWalk(benchmark::State& state) {
+  std::unique_ptr<AllocationPolicy> policy;
+  if (state.range(0)) policy = std::make_unique<PoolAllocationPolicy>();
+  else policy = std::make_unique<HeapAllocationPolicy>();
+  OrderBook book(std::move(policy));
+  NullSink sink;
+
+  runRandomWalk(state, book, sink);
+}
+BENCHMARK(BM_Allocation_RandomWalk)->ArgName("pool")->Arg(0)->Arg(1);
+
+// Trade output through the vector adapter, which keeps every trade the way
+// src/main.cpp used to, versus a sink that drops them.
+static void BM_Sink_RandomWalk_Vector(benchmark::State& state) {
+  OrderBook book;
+  std::vector<Trade> trades;
+
+  runRandomWalk(state, book, trades);
+  state.counters["trade_bytes"] = static_cast<double>(trades.capacity() * sizeof(Trade));
+}
+BENCHMARK(BM_Sink_RandomWalk_Vector);
+
+static void BM_Sink_RandomWalk_Null(benchmark::State& state) {
+  OrderBook book;
+  NullSink sink;
+
+  runRandomWalk(state, book, sink);
+}
+BENCHMARK(BM_Sink_RandomWalk_Null);
+
+// A 1M-order book whose queues were built interleaved across levels, as a
+// long-lived book ends up: neighbours in a FIFO were allocated far apart, so
+// walking a queue or touching a random order mostly misses cache.
+static constexpr int ColdBookOrders = 1000000;
+static constexpr int ColdBookLevels = 1000;
+
+static Price coldBookPrice(int id) { return Price(10000LL + (id - 1) % ColdBookLevels); }
+
+static void fillColdBook(OrderBook& book, ExecutionSink& sink) {
+  for (int id = 1; id <= ColdBookOrders; ++id) {
+    book.addOrder<orderType::GTC, false>(id, coldBookPrice(id), 10, 1000 + id % 5000, sink);
+  }
+}
+
+// Each iteration sweeps 64 orders off the best ask with an IOC and rests 64
+// new ones behind them, so the book stays at 1M orders.
+static void BM_ColdBook_Match(benchmark::State& state) {
+  OrderBook book;
+  NullSink sink;
+  fillColdBook(book, sink);
+  int nextId = ColdBookOrders + 1;
+
+  for (auto _ : state) {
+    Price best = book.bestAsk().price;
+    book.addOrder<orderType::IOC, true>(nextId++, best, 64 * 10, 1, sink);
+    for (int i = 0; i < 64; ++i) book.addOrder<orderType::GTC, false>(nextId++, best, 10, 1000 + i, sink);
+  }
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_ColdBook_Match)->Unit(benchmark::kMicrosecond);
+
+// Cancels a random resting order and rests it again at the back of its level.
+static void BM_ColdBook_CancelReplace(benchmark::State& state) {
+  OrderBook book;
+  NullSink sink;
+  fillColdBook(book, sink);
+  std::mt19937 gen(7);
+
+  for (auto _ : state) {
+    int id = 1 + static_cast<int>(gen() % ColdBookOrders);
+    book.cancelOrder(id, sink);
+    book.addOrder<orderType::GTC, false>(id, coldBookPrice(id), 10, 1000 + id % 5000, sink);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ColdBook_CancelReplace);
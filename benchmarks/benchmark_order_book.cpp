@@ -1,14 +1,23 @@
 #include <benchmark/benchmark.h>
+#include "Clock.h"
 #include "OrderBook.h"
 #include "Order.h"
 #include "Trade.h"
 #include <vector>
 #include <random>
+#include <memory>
 
 double generate_price(int i) {
     return 100.0 + (i % 1000) * 0.05;
 }
 
+// Band used by the ladder-mode variants; covers every price the benchmarks use.
+static const LadderConfig kLadder{50.0, 200.0, 1};
+
+static std::unique_ptr<OrderBook> makeBook(bool ladder) {
+  return ladder ? std::make_unique<OrderBook>(kLadder) : std::make_unique<OrderBook>();
+}
+
 static void BM_AddOrder_EmptyBook(benchmark::State& state) {
   for (auto _ : state) {
     state.PauseTiming();
@@ -29,20 +38,25 @@ static void BM_AddOrder_WithExistingOrders(benchmark::State& state) {
     
   for (auto _ : state) {
     state.PauseTiming();
-    OrderBook book;
+    auto book = std::make_unique<OrderBook>();
     std::vector<Trade> trades;
 
     for (int i = 0; i < numExisting; ++i) {
-      book.addOrder(i, generate_price(i), 10, i % 2 == 0, 1000 + i, orderType::GTC, trades);
+      book->addOrder(i, generate_price(i), 10, i % 2 == 0, 1000 + i, orderType::GTC, trades);
     }
 
     trades.clear();
     state.ResumeTiming();
 
-    book.addOrder(numExisting + 1, 105.0, 10, true, 2001, orderType::GTC, trades);
+    book->addOrder(numExisting + 1, 105.0, 10, true, 2001, orderType::GTC, trades);
 
-    benchmark::DoNotOptimize(book);
+    benchmark::DoNotOptimize(book.get());
     benchmark::DoNotOptimize(trades);
+
+    // Tearing down the book is O(N) and not part of the measured operation.
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
   }
 }
 
@@ -82,6 +96,31 @@ static void BM_AddOrder_PartialFill(benchmark::State& state) {
 }
 BENCHMARK(BM_AddOrder_PartialFill);
 
+static void BM_AddOrder_PartialFill_DeepQueue(benchmark::State& state) {
+  int depth = state.range(0);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>();
+    std::vector<Trade> trades;
+    for (int i = 0; i < depth; ++i) {
+      book->addOrder(i, 100.0, 50, false, 1000 + i, orderType::GTC, trades);
+    }
+    state.ResumeTiming();
+
+    // Partially fills the head of the queue, which must keep its position.
+    book->addOrder(depth, 100.0, 25, true, 2000, orderType::GTC, trades);
+
+    benchmark::DoNotOptimize(book.get());
+    benchmark::DoNotOptimize(trades);
+
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(BM_AddOrder_PartialFill_DeepQueue)->RangeMultiplier(10)->Range(10, 10000);
+
 static void BM_AddOrder_MultipleLevelFill(benchmark::State& state) {
   int numLevels = state.range(0);
 
@@ -140,28 +179,196 @@ static void BM_AddOrder_FOK(benchmark::State& state) {
 }
 BENCHMARK(BM_AddOrder_FOK);
 
+// IOC and FOK orders on both sides, each taking one lot from a deep resting
+// level, sent through the run-time dispatch (specialized:0) or straight to
+// the compile-time instantiation (specialized:1).
+static void BM_AddOrder_Dispatch(benchmark::State& state) {
+  const bool specialized = state.range(0) != 0;
+  OrderBook book;
+  NullSink sink;
+  book.addOrder(1, 100.0, 1000000000, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 99.0, 1000000000, true, 1001, orderType::GTC, sink);
+  const Price ask(100.0);
+  const Price bid(99.0);
+  int id = 3;
+
+  for (auto _ : state) {
+    if (specialized) {
+      book.addOrder<orderType::IOC, true>(id++, ask, 1, 1002, sink);
+      book.addOrder<orderType::IOC, false>(id++, bid, 1, 1002, sink);
+      book.addOrder<orderType::FOK, true>(id++, ask, 1, 1002, sink);
+      book.addOrder<orderType::FOK, false>(id++, bid, 1, 1002, sink);
+    } else {
+      book.addOrder(id++, ask, 1, true, 1002, orderType::IOC, sink);
+      book.addOrder(id++, bid, 1, false, 1002, orderType::IOC, sink);
+      book.addOrder(id++, ask, 1, true, 1002, orderType::FOK, sink);
+      book.addOrder(id++, bid, 1, false, 1002, orderType::FOK, sink);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_AddOrder_Dispatch)->ArgName("specialized")->Arg(0)->Arg(1);
+
+// Matches against the touch while range(0) stops wait far from it; the
+// trigger check should cost the same whether none or many are dormant.
+static void BM_Match_DormantStops(benchmark::State& state) {
+  const int stopCount = state.range(0);
+  OrderBook book;
+  NullSink sink;
+  book.addOrder(1, 100.0, 1000000000, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 99.0, 1000000000, true, 1001, orderType::GTC, sink);
+  for (int i = 0; i < stopCount; ++i) {
+    bool isBuy = i % 2 == 0;
+    Price stopPrice(isBuy ? 15000LL + i : 5000LL - i);
+    book.addStopOrder(10 + i, stopPrice, stopPrice, 1, isBuy, 3001, orderType::STOP_LIMIT, sink);
+  }
+  const Price ask(100.0);
+  const Price bid(99.0);
+  int id = 10 + stopCount;
+
+  for (auto _ : state) {
+    book.addOrder<orderType::IOC, true>(id++, ask, 1, 1002, sink);
+    book.addOrder<orderType::IOC, false>(id++, bid, 1, 1002, sink);
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+}
+BENCHMARK(BM_Match_DormantStops)->ArgName("stops")->Arg(0)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// A market maker quotes 1000 orders at the offer with another user's order
+// queued behind them, then lifts that offer itself with IOC buys. Every buy
+// conflicts with the maker's own stack, and a removed order is re-posted
+// at the back (mode: CancelNewest, CancelOldest, CancelBoth, Decrement).
+// CancelOldest clears the whole stack on the first buy and then trades with
+// the other user; the other modes keep the stack full.
+static void BM_SelfTrade_QuotedBook(benchmark::State& state) {
+  const int stack = 1000;
+  OrderBook book;
+  book.setSelfTradePrevention(static_cast<SelfTradePrevention>(state.range(0)));
+  NullSink sink;
+  for (int i = 0; i < stack; ++i) book.addOrder(i, 100.0, 1000000, false, 1001, orderType::GTC, sink);
+  book.addOrder(stack, 100.0, 1000000000, false, 1002, orderType::GTC, sink);
+  const Price offer(100.0);
+  int id = stack + 1;
+
+  for (auto _ : state) {
+    book.addOrder<orderType::IOC, true>(id++, offer, 1, 1001, sink);
+    if (book.restingOrderCount() <= static_cast<size_t>(stack)) book.addOrder<orderType::GTC, false>(id++, offer, 1000000, 1001, sink);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SelfTrade_QuotedBook)->ArgName("mode")->DenseRange(0, 3);
+
+// Cancel-on-disconnect for one user quoting `orders` orders across 100
+// levels in a book where 1000 other users rest 200k more. The session's
+// quotes are put back between iterations.
+static void BM_MassCancel_User(benchmark::State& state) {
+  const int orders = state.range(0);
+  const int others = 200000;
+  OrderBook book;
+  NullSink sink;
+  for (int id = 0; id < others; ++id) book.addOrder(id, Price(10100LL + id % 500), 10, false, id % 1000, orderType::GTC, sink);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int i = 0; i < orders; ++i) book.addOrder(others + i, Price(10100LL + i % 100), 10, false, 5000, orderType::GTC, sink);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(book.cancelAllForUser(5000, sink));
+  }
+  state.SetItemsProcessed(state.iterations() * orders);
+}
+BENCHMARK(BM_MassCancel_User)->RangeMultiplier(10)->Range(10, 10000);
+
+static void BM_AddOrder_FOK_DeepBook(benchmark::State& state) {
+  int ordersPerLevel = state.range(0);
+  int levels = 10;
+
+  OrderBook book;
+  std::vector<Trade> trades;
+  int id = 0;
+  for (int level = 0; level < levels; ++level) {
+    for (int i = 0; i < ordersPerLevel; ++i) {
+      book.addOrder(id++, 100.0 + level * 0.01, 10, false, 1000 + i, orderType::GTC, trades);
+    }
+  }
+  int available = 10 * ordersPerLevel * levels;
+
+  // One lot more than the crossing levels hold, so the feasibility check
+  // covers every level and the order is killed without touching the book.
+  for (auto _ : state) {
+    book.addOrder(id, 100.0 + levels * 0.01, available + 1, true, 2000, orderType::FOK, trades);
+
+    benchmark::DoNotOptimize(book);
+  }
+}
+BENCHMARK(BM_AddOrder_FOK_DeepBook)->RangeMultiplier(10)->Range(10, 1000);
+
+// Add and cancel with no clock (0), the TSC (1) or the system clock (2).
+static void BM_AddOrder_ClockSource(benchmark::State& state) {
+  TscClock tsc;
+  SystemClock system;
+  OrderBook book;
+  if (state.range(0) == 1) book.setClock(&tsc);
+  if (state.range(0) == 2) book.setClock(&system);
+  std::vector<Trade> trades;
+
+  int id = 0;
+  for (auto _ : state) {
+    book.addOrder(id, 100.0, 10, true, 1001, orderType::GTC, trades);
+    book.cancelOrder(id++);
+
+    benchmark::DoNotOptimize(book);
+  }
+}
+BENCHMARK(BM_AddOrder_ClockSource)->ArgName("clock")->DenseRange(0, 2);
+
 static void BM_CancelOrder_DenseBook(benchmark::State& state) {
   int numOrders = state.range(0);
     
   for (auto _ : state) {
     state.PauseTiming();
-    OrderBook book;
+    auto book = std::make_unique<OrderBook>();
     std::vector<Trade> trades;
 
     for (int i = 0; i < numOrders; ++i) {
-      book.addOrder(i, 100.0, 10, true, 1000 + i, orderType::GTC, trades);
+      book->addOrder(i, 100.0, 10, true, 1000 + i, orderType::GTC, trades);
     }
     
     state.ResumeTiming();
 
-    book.cancelOrder(numOrders / 2);
+    book->cancelOrder(numOrders / 2);
         
-    benchmark::DoNotOptimize(book);
+    benchmark::DoNotOptimize(book.get());
+
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
   }
 }
 BENCHMARK(BM_CancelOrder_DenseBook)->RangeMultiplier(10)->Range(100, 100000);
 
-static void BM_ModifyOrder(benchmark::State& state) {
+static void BM_ModifyOrder_ReduceOnly(benchmark::State& state) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  for (int i = 0; i < 1000; ++i) {
+    book.addOrder(i, 100.0 - (i % 10) * 0.01, 1 << 30, true, 1000 + i, orderType::GTC, trades);
+  }
+
+  // Amends in place at the same price; the order keeps its queue position.
+  int id = 0;
+  int quantity = (1 << 30) - 1;
+  for (auto _ : state) {
+    book.modifyOrder(id, 100.0 - (id % 10) * 0.01, quantity, trades);
+    if (++id == 1000) {
+      id = 0;
+      --quantity;
+    }
+
+    benchmark::DoNotOptimize(book);
+  }
+}
+BENCHMARK(BM_ModifyOrder_ReduceOnly);
+
+static void BM_ModifyOrder_Reprice(benchmark::State& state) {
   for (auto _ : state) {
     state.PauseTiming();
 
@@ -179,7 +386,7 @@ static void BM_ModifyOrder(benchmark::State& state) {
     benchmark::DoNotOptimize(trades);
   }
 }
-BENCHMARK(BM_ModifyOrder);
+BENCHMARK(BM_ModifyOrder_Reprice);
 
 static void BM_HighLoad_MixedOperations(benchmark::State& state) {
   int initialOrders = 10000;
@@ -234,4 +441,266 @@ static void BM_WorstCase_DeepBook_Match(benchmark::State& state) {
 }
 BENCHMARK(BM_WorstCase_DeepBook_Match)->Range(100, 2000);
 
+// Same liquidity as BM_WorstCase_DeepBook_Match, posted as one iceberg
+// showing 10 at a time instead of range(0) separate child orders.
+static void BM_WorstCase_DeepBook_Match_Iceberg(benchmark::State& state) {
+  int depth = state.range(0);
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    OrderBook book;
+    std::vector<Trade> trades;
+    NullSink sink;
+    book.addIcebergOrder(0, 100.0, 10 * depth, 10, false, 1000, sink);
+
+    state.ResumeTiming();
+
+    book.addOrder(99999, 100.0, 10 * depth, true, 2000, orderType::GTC, trades);
+
+    benchmark::DoNotOptimize(book);
+  }
+}
+BENCHMARK(BM_WorstCase_DeepBook_Match_Iceberg)->Range(100, 2000);
+
+// ============================================================================
+// Tree vs ladder mode (second argument: 0 = tree, 1 = ladder)
+// ============================================================================
+
+static void BM_BookMode_LevelSweep(benchmark::State& state) {
+  int numLevels = state.range(0);
+  auto book = makeBook(state.range(1));
+  std::vector<Trade> trades;
+  int id = 0;
+
+  // The book is reused so both modes are measured with warm level storage.
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int i = 0; i < numLevels; ++i) {
+      book->addOrder(id++, 100.0 + i * 0.01, 10, false, 1000 + i, orderType::GTC, trades);
+    }
+    trades.clear();
+    state.ResumeTiming();
+
+    book->addOrder(id++, 200.0, 10 * numLevels, true, 2000, orderType::IOC, trades);
+
+    benchmark::DoNotOptimize(book.get());
+    benchmark::DoNotOptimize(trades);
+  }
+}
+BENCHMARK(BM_BookMode_LevelSweep)->ArgNames({"levels", "ladder"})->ArgsProduct({{5, 50, 500}, {0, 1}});
+
+static void BM_BookMode_TouchChurn(benchmark::State& state) {
+  auto book = makeBook(state.range(0));
+  std::vector<Trade> trades;
+  for (int i = 0; i < 1000; ++i) {
+    book->addOrder(i, 99.99 - i * 0.01, 10, true, i, orderType::GTC, trades);
+    book->addOrder(1000 + i, 100.01 + i * 0.01, 10, false, i, orderType::GTC, trades);
+  }
+
+  // Each iteration opens a new best level and removes it again.
+  int id = 2000;
+  for (auto _ : state) {
+    book->addOrder(id, 100.0, 10, true, 1, orderType::GTC, trades);
+    book->cancelOrder(id++);
+    benchmark::DoNotOptimize(book.get());
+  }
+}
+BENCHMARK(BM_BookMode_TouchChurn)->ArgName("ladder")->Arg(0)->Arg(1);
+
+static void BM_BookMode_MixedOperations(benchmark::State& state) {
+  int initialOrders = 10000;
+
+  auto book = makeBook(state.range(0));
+  std::vector<Trade> trades;
+  for (int i = 0; i < initialOrders; ++i) {
+    bool isBuy = (i % 2 == 0);
+    double price = isBuy ? (99.0 - (i%100)*0.01) : (101.0 + (i%100)*0.01);
+    book->addOrder(i, price, 100, isBuy, i, orderType::GTC, trades);
+  }
+
+  int nextId = initialOrders;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> op_dist(0, 2);
+  std::uniform_int_distribution<int> id_dist(0, initialOrders - 1);
+
+  for (auto _ : state) {
+    int op = op_dist(rng);
+
+    if (op == 0) {
+      book->addOrder(nextId, 90.0, 10, true, nextId, orderType::GTC, trades);
+    } else if (op == 1) {
+      book->cancelOrder(id_dist(rng));
+    } else {
+      book->addOrder(nextId, 102.0, 5, true, nextId, orderType::IOC, trades);
+    }
+    ++nextId;
+
+    benchmark::DoNotOptimize(book.get());
+  }
+}
+BENCHMARK(BM_BookMode_MixedOperations)->ArgName("ladder")->Arg(0)->Arg(1);
+
+// ============================================================================
+// Market data
+// ============================================================================
+
+static void BM_Depth_TopN(benchmark::State& state) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  for (int i = 0; i < 10000; ++i) {
+    bool isBuy = (i % 2 == 0);
+    double price = isBuy ? (99.0 - (i%100)*0.01) : (101.0 + (i%100)*0.01);
+    book.addOrder(i, price, 100, isBuy, i, orderType::GTC, trades);
+  }
+
+  std::vector<DepthLevel> levels(state.range(0));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(book.depth(true, levels.data(), levels.size()));
+    benchmark::DoNotOptimize(book.depth(false, levels.data(), levels.size()));
+  }
+}
+BENCHMARK(BM_Depth_TopN)->Arg(5)->Arg(10)->Arg(50);
+
+static void BM_TopOfBook_SeqlockRead(benchmark::State& state) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 101.0, 10, false, 1002, orderType::GTC, trades);
+
+  unsigned long long version = 0;
+  for (auto _ : state) {
+    TopOfBook top = book.topOfBook().load(&version);
+    benchmark::DoNotOptimize(top);
+  }
+}
+BENCHMARK(BM_TopOfBook_SeqlockRead);
+
+// Mixed workload with and without a conflating depth feed drained every 64 operations.
+static void BM_DepthFeed_MixedOperations(benchmark::State& state) {
+  int initialOrders = 10000;
+
+  OrderBook book;
+  DepthFeed feed;
+  if (state.range(0)) book.setDepthFeed(&feed);
+  std::vector<Trade> trades;
+  for (int i = 0; i < initialOrders; ++i) {
+    bool isBuy = (i % 2 == 0);
+    double price = isBuy ? (99.0 - (i%100)*0.01) : (101.0 + (i%100)*0.01);
+    book.addOrder(i, price, 100, isBuy, i, orderType::GTC, trades);
+  }
+  feed.clear();
+
+  int nextId = initialOrders;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> op_dist(0, 2);
+  std::uniform_int_distribution<int> id_dist(0, initialOrders - 1);
+  long long published = 0;
+
+  for (auto _ : state) {
+    int op = op_dist(rng);
+
+    if (op == 0) {
+      book.addOrder(nextId, 90.0, 10, true, nextId, orderType::GTC, trades);
+    } else if (op == 1) {
+      book.cancelOrder(id_dist(rng));
+    } else {
+      book.addOrder(nextId, 102.0, 5, true, nextId, orderType::IOC, trades);
+    }
+    if (++nextId % 64 == 0) published += feed.drain([](const LevelDelta& delta) { benchmark::DoNotOptimize(delta); });
+    trades.clear();
+
+    benchmark::DoNotOptimize(book);
+  }
+  state.counters["deltas_per_op"] = benchmark::Counter(static_cast<double>(published) / state.iterations());
+}
+BENCHMARK(BM_DepthFeed_MixedOperations)->ArgName("feed")->Arg(0)->Arg(1);
+
+// ============================================================================
+// Batched commands (argument: commands per applyBatch call)
+// ============================================================================
+
+// 200k resting orders away from the touch, and a stream that cancels a
+// random one and re-adds it at the same price, so the stream can be
+// replayed forever against a book of constant shape.
+static void BM_ApplyBatch(benchmark::State& state) {
+  const int restingOrders = 200000;
+  const size_t batchSize = state.range(0);
+  auto priceOf = [](int id) { return id % 2 == 0 ? Price(9900LL - id % 500) : Price(10100LL + id % 500); };
+
+  OrderBook book;
+  TscClock clock;
+  book.setClock(&clock);
+  NullSink sink;
+  for (int id = 0; id < restingOrders; ++id) book.addOrder(id, priceOf(id), 10, id % 2 == 0, id % 1000, orderType::GTC, sink);
+
+  std::mt19937 rng(42);
+  std::vector<Command> stream;
+  for (int i = 0; i < 1 << 16; ++i) {
+    int id = rng() % restingOrders;
+    stream.push_back(Command::cancel(id));
+    stream.push_back(Command::add(id, priceOf(id), 10, id % 2 == 0, id % 1000));
+  }
+
+  size_t position = 0;
+  for (auto _ : state) {
+    if (position + batchSize > stream.size()) position = 0;
+    book.applyBatch(stream.data() + position, batchSize, sink);
+    position += batchSize;
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+}
+BENCHMARK(BM_ApplyBatch)->ArgName("batch")->Arg(1)->Arg(8)->Arg(64)->Arg(512);
+
+// ============================================================================
+// Order expiry
+// ============================================================================
+
+// 1M DAY orders across 1000 levels on both sides, all expired by the one
+// advanceTime() at the session close.
+static void BM_Expiry_SessionBell(benchmark::State& state) {
+  const int orders = 1000000;
+  const long long close = 8LL * 3600 * 1000000000;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto book = std::make_unique<OrderBook>();
+    book->setSessionClose(close);
+    NullSink sink;
+    for (int id = 0; id < orders; ++id) {
+      bool isBuy = id % 2 == 0;
+      book->addOrder(id, Price(isBuy ? 9900LL - id % 1000 : 10100LL + id % 1000), 10, isBuy, id % 1000, orderType::DAY, sink);
+    }
+    state.ResumeTiming();
+    book->advanceTime(close, sink);
+    state.PauseTiming();
+    book.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * orders);
+}
+BENCHMARK(BM_Expiry_SessionBell)->Unit(benchmark::kMillisecond)->Iterations(5);
+
+// Cancel and re-add of a random order in a 100k-order book of GTC (0) or
+// GTD (1) orders whose expiries are spread over a trading day, so the
+// difference is what the wheel adds to ordinary order entry and removal.
+static void BM_Expiry_AddCancelOverhead(benchmark::State& state) {
+  const int restingOrders = 100000;
+  const long long day = 8LL * 3600 * 1000000000;
+  const orderType type = state.range(0) ? orderType::GTD : orderType::GTC;
+  auto priceOf = [](int id) { return id % 2 == 0 ? Price(9900LL - id % 500) : Price(10100LL + id % 500); };
+  auto expiryOf = [day](int id) { return day / 2 + static_cast<long long>(id) * 1000003 % (day / 2); };
+
+  OrderBook book;
+  NullSink sink;
+  for (int id = 0; id < restingOrders; ++id) book.addOrder(id, priceOf(id), 10, id % 2 == 0, id % 1000, type, expiryOf(id), sink);
+
+  std::mt19937 rng(42);
+  for (auto _ : state) {
+    int id = rng() % restingOrders;
+    book.cancelOrder(id, sink);
+    book.addOrder(id, priceOf(id), 10, id % 2 == 0, id % 1000, type, expiryOf(id), sink);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Expiry_AddCancelOverhead)->ArgName("gtd")->Arg(0)->Arg(1);
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,176 @@
+#pragma once
+
+#include "Order.h"
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Free list of fixed-size blocks carved out of large slabs. Freed blocks are
+// recycled, so once the pool has grown to the working-set size allocation
+// never reaches the global heap. Slabs start small and double up to
+// maxBlocksPerSlab, and fresh blocks are bump-allocated, so an idle book
+// costs almost nothing. The block size may be left at zero and is then
+// fixed by the first request. Blocks are aligned to alignment, which also
+// rounds up their size, so cache-line-sized blocks never straddle lines.
+class FixedPool {
+private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  struct SlabDeleter {
+    size_t alignment;
+    void operator()(unsigned char* slab) const { ::operator delete(slab, std::align_val_t(alignment)); }
+  };
+
+  static constexpr size_t InitialBlocksPerSlab = 64;
+
+  size_t alignment;
+  size_t blockSize;
+  size_t maxBlocksPerSlab;
+  size_t nextSlabBlocks = InitialBlocksPerSlab;
+  FreeBlock* freeList = nullptr;
+  unsigned char* bump = nullptr;
+  unsigned char* bumpEnd = nullptr;
+  size_t reserved = 0;
+  std::vector<std::unique_ptr<unsigned char, SlabDeleter>> slabs;
+
+  size_t roundUp(size_t size) const {
+    size = size < sizeof(FreeBlock) ? sizeof(FreeBlock) : size;
+    return (size + alignment - 1) / alignment * alignment;
+  }
+
+  void grow() {
+    size_t bytes = blockSize * nextSlabBlocks;
+    auto* slab = static_cast<unsigned char*>(::operator new(bytes, std::align_val_t(alignment)));
+    slabs.emplace_back(slab, SlabDeleter{alignment});
+    bump = slabs.back().get();
+    bumpEnd = bump + bytes;
+    reserved += bytes;
+    if (nextSlabBlocks < maxBlocksPerSlab) nextSlabBlocks = std::min(nextSlabBlocks * 2, maxBlocksPerSlab);
+  }
+
+public:
+  explicit FixedPool(size_t blockSize_ = 0, size_t maxBlocksPerSlab_ = 4096, size_t alignment_ = alignof(std::max_align_t))
+    : alignment(alignment_), blockSize(blockSize_ ? roundUp(blockSize_) : 0), maxBlocksPerSlab(maxBlocksPerSlab_) {
+    if (nextSlabBlocks > maxBlocksPerSlab) nextSlabBlocks = maxBlocksPerSlab;
+  }
+
+  FixedPool(const FixedPool&) = delete;
+  FixedPool& operator=(const FixedPool&) = delete;
+
+  // True if blocks of this size are served by the pool.
+  bool fits(size_t size) {
+    if (!blockSize) blockSize = roundUp(size);
+    return roundUp(size) == blockSize;
+  }
+
+  void* allocate() {
+    if (freeList) {
+      FreeBlock* block = freeList;
+      freeList = block->next;
+      return block;
+    }
+    if (bump == bumpEnd) grow();
+    void* block = bump;
+    bump += blockSize;
+    return block;
+  }
+
+  void deallocate(void* ptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    block->next = freeList;
+    freeList = block;
+  }
+
+  size_t reservedBytes() const { return reserved; }
+};
+
+// Where OrderBook gets memory for resting orders, their OrderDetails and
+// tree price levels (the map nodes that hold a PriceLevel). Orders must be
+// aligned to alignof(Order).
+class AllocationPolicy {
+public:
+  virtual ~AllocationPolicy() = default;
+
+  virtual void* allocateOrder() = 0;
+  virtual void deallocateOrder(void* ptr) = 0;
+  virtual void* allocateDetails() = 0;
+  virtual void deallocateDetails(void* ptr) = 0;
+  virtual void* allocateLevel(size_t size) = 0;
+  virtual void deallocateLevel(void* ptr, size_t size) = 0;
+};
+
+// Plain global-heap allocation for every node.
+class HeapAllocationPolicy : public AllocationPolicy {
+public:
+  void* allocateOrder() override { return ::operator new(sizeof(Order), std::align_val_t(alignof(Order))); }
+  void deallocateOrder(void* ptr) override { ::operator delete(ptr, std::align_val_t(alignof(Order))); }
+  void* allocateDetails() override { return ::operator new(sizeof(OrderDetails)); }
+  void deallocateDetails(void* ptr) override { ::operator delete(ptr); }
+  void* allocateLevel(size_t size) override { return ::operator new(size); }
+  void deallocateLevel(void* ptr, size_t) override { ::operator delete(ptr); }
+};
+
+// Default policy: slab pools for orders and their details and a recycled free
+// list for price levels. Orders sit one per cache line in their own slabs, so
+// the records a match walks are dense. Levels that empty near the touch and
+// reappear reuse the same nodes.
+class PoolAllocationPolicy : public AllocationPolicy {
+private:
+  FixedPool orders;
+  FixedPool details;
+  FixedPool levels;
+
+public:
+  explicit PoolAllocationPolicy(size_t maxOrdersPerSlab = 4096, size_t maxLevelsPerSlab = 256)
+    : orders(sizeof(Order), maxOrdersPerSlab, alignof(Order)), details(sizeof(OrderDetails), maxOrdersPerSlab, alignof(OrderDetails)),
+      levels(0, maxLevelsPerSlab) {}
+
+  void* allocateOrder() override { return orders.allocate(); }
+  void deallocateOrder(void* ptr) override { orders.deallocate(ptr); }
+  void* allocateDetails() override { return details.allocate(); }
+  void deallocateDetails(void* ptr) override { details.deallocate(ptr); }
+
+  void* allocateLevel(size_t size) override {
+    return levels.fits(size) ? levels.allocate() : ::operator new(size);
+  }
+  void deallocateLevel(void* ptr, size_t size) override {
+    if (levels.fits(size)) levels.deallocate(ptr);
+    else ::operator delete(ptr);
+  }
+};
+
+// std::allocator adapter that routes single-node allocations (tree nodes)
+// through an AllocationPolicy. Without a policy it uses the global heap.
+template <typename T>
+class LevelAllocator {
+private:
+  template <typename U> friend class LevelAllocator;
+  AllocationPolicy* policy = nullptr;
+
+public:
+  using value_type = T;
+
+  LevelAllocator() = default;
+  explicit LevelAllocator(AllocationPolicy* policy_) : policy(policy_) {}
+  template <typename U>
+  LevelAllocator(const LevelAllocator<U>& other) : policy(other.policy) {}
+
+  T* allocate(size_t n) {
+    if (policy && n == 1) return static_cast<T*>(policy->allocateLevel(sizeof(T)));
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if (policy && n == 1) policy->deallocateLevel(ptr, sizeof(T));
+    else ::operator delete(ptr);
+  }
+
+  template <typename U>
+  bool operator==(const LevelAllocator<U>& other) const { return policy == other.policy; }
+  template <typename U>
+  bool operator!=(const LevelAllocator<U>& other) const { return policy != other.policy; }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "AllocationPolicy.h"
+#include "PriceLadder.h"
+#include "PriceLevel.h"
+#include "Price.h"
+#include <functional>
+#include <map>
+#include <type_traits>
+
+// One side of the book. Levels inside the optional ladder band live in a
+// dense array; every other price falls back to the tree. Traversal merges
+// both sources in priority order (best price first).
+template <typename Compare>
+class BookSide {
+public:
+  using Tree = std::map<Price, PriceLevel, Compare, LevelAllocator<std::pair<const Price, PriceLevel>>>;
+
+  template <typename Iter, typename Level>
+  struct BasicCursor {
+    Iter treeIt;
+    int ladderIndex = -1;
+    bool onLadder = false;
+    Level* level = nullptr;
+  };
+  using Cursor = BasicCursor<typename Tree::iterator, PriceLevel>;
+  using ConstCursor = BasicCursor<typename Tree::const_iterator, const PriceLevel>;
+
+  // Bids are the side ordered best-first by descending price.
+  static constexpr bool IsBidSide = std::is_same_v<Compare, std::greater<Price>>;
+
+private:
+  static constexpr bool Descending = IsBidSide;
+
+  Tree tree;
+  PriceLadder ladder;
+  int bestIndex = -1;
+
+  bool ladderBetter(int a, int b) const { return Descending ? a > b : a < b; }
+  int nextWorse(int index) const { return Descending ? ladder.nextDown(index - 1) : ladder.nextUp(index + 1); }
+
+  // Points the cursor at whichever of the tree and ladder heads is better.
+  template <typename Self, typename C>
+  static void settle(Self& self, C& cursor) {
+    bool hasTree = cursor.treeIt != self.tree.end();
+    bool hasLadder = cursor.ladderIndex >= 0;
+
+    if (hasTree && (!hasLadder || self.tree.key_comp()(cursor.treeIt->first, self.ladder.at(cursor.ladderIndex).price))) {
+      cursor.onLadder = false;
+      cursor.level = &cursor.treeIt->second;
+    } else if (hasLadder) {
+      cursor.onLadder = true;
+      cursor.level = &self.ladder.at(cursor.ladderIndex);
+    } else {
+      cursor.level = nullptr;
+    }
+  }
+
+  template <typename Self, typename C>
+  static void advance(Self& self, C& cursor) {
+    if (cursor.onLadder) cursor.ladderIndex = self.nextWorse(cursor.ladderIndex);
+    else ++cursor.treeIt;
+    settle(self, cursor);
+  }
+
+  void releaseLadderIndex(int index) {
+    ladder.clearOccupied(index);
+    if (index == bestIndex) bestIndex = nextWorse(index);
+  }
+
+public:
+  BookSide() = default;
+  explicit BookSide(AllocationPolicy* policy)
+    : tree(Compare(), typename Tree::allocator_type(policy)) {}
+  BookSide(const LadderConfig& config, AllocationPolicy* policy)
+    : tree(Compare(), typename Tree::allocator_type(policy)), ladder(config) {}
+
+  bool hasLadder() const { return ladder.enabled(); }
+  bool empty() const { return tree.empty() && bestIndex < 0; }
+
+  // True when a resting level at levelPrice is marketable against limit.
+  bool crosses(Price limit, Price levelPrice) const { return !tree.key_comp()(limit, levelPrice); }
+
+  PriceLevel& levelFor(Price price) {
+    int index = ladder.enabled() ? ladder.indexOf(price) : -1;
+    if (index < 0) return tree.try_emplace(price, price).first->second;
+
+    PriceLevel& level = ladder.at(index);
+    if (level.empty()) {
+      ladder.setOccupied(index);
+      if (bestIndex < 0 || ladderBetter(index, bestIndex)) bestIndex = index;
+    }
+    return level;
+  }
+
+  // levelFor() for a price known to rank behind every existing level, as
+  // when levels are rebuilt in priority order; the tree insert is O(1).
+  PriceLevel& appendLevel(Price price) {
+    if (ladder.enabled() && ladder.indexOf(price) >= 0) return levelFor(price);
+    return tree.try_emplace(tree.end(), price, price)->second;
+  }
+
+  // Drops a level that has just become empty.
+  void eraseLevel(PriceLevel* level) {
+    if (ladder.owns(level)) releaseLadderIndex(ladder.indexOf(level));
+    else tree.erase(level->price);
+  }
+
+  Cursor begin() {
+    Cursor cursor{tree.begin(), bestIndex};
+    settle(*this, cursor);
+    return cursor;
+  }
+
+  ConstCursor begin() const {
+    ConstCursor cursor{tree.begin(), bestIndex};
+    settle(*this, cursor);
+    return cursor;
+  }
+
+  void advance(Cursor& cursor) { advance(*this, cursor); }
+  void advance(ConstCursor& cursor) const { advance(*this, cursor); }
+
+  // Removes the (empty) level under the cursor and moves to the next one.
+  void eraseAndAdvance(Cursor& cursor) {
+    if (cursor.onLadder) {
+      int index = cursor.ladderIndex;
+      cursor.ladderIndex = nextWorse(index);
+      releaseLadderIndex(index);
+    } else {
+      cursor.treeIt = tree.erase(cursor.treeIt);
+    }
+    settle(*this, cursor);
+  }
+};
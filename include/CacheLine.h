@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstddef>
+
+// Alignment used to keep data shared between threads off each other's lines.
+constexpr size_t CacheLineSize = 64;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Source of the timestamps stamped on orders and trades. Priority within a
+// level comes from queue position and the book's sequence counter, so the
+// clock only labels events and can be swapped without changing matching.
+class Clock {
+public:
+  virtual ~Clock() = default;
+  virtual long long now() = 0;
+};
+
+// Wall-clock nanoseconds since the epoch (a vDSO call on Linux).
+class SystemClock : public Clock {
+public:
+  long long now() override {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  }
+};
+
+// Raw CPU cycle counter: a few nanoseconds to read, in ticks rather than
+// nanoseconds. Falls back to steady_clock on other architectures.
+class TscClock : public Clock {
+public:
+  long long now() override {
+#if defined(__x86_64__) || defined(__i386__)
+    return static_cast<long long>(__rdtsc());
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return static_cast<long long>(ticks);
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+};
+
+// Caller-driven time, e.g. exchange timestamps from a feed or a journal
+// being replayed. Makes every stamped timestamp deterministic.
+class ManualClock : public Clock {
+private:
+  long long time = 0;
+
+public:
+  explicit ManualClock(long long start = 0) : time(start) {}
+
+  long long now() override { return time; }
+  void set(long long nanoseconds) { time = nanoseconds; }
+  void advance(long long nanoseconds) { time += nanoseconds; }
+};
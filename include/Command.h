@@ -0,0 +1,93 @@
+#pragma once
+
+#include "OrderType.h"
+#include "Price.h"
+#include <cstdint>
+#include <type_traits>
+
+enum struct CommandType : uint8_t {
+  Add,
+  Cancel,
+  Modify,
+  // Expires GTD and DAY orders due by the book's clock time.
+  AdvanceTime
+};
+
+// Fixed-size, trivially copyable inbound request. The same record is queued
+// between threads, written to the journal and replayed, so it carries no
+// pointers. timestamp is the ingress time in nanoseconds (0 if unset), and
+// instrument selects the book when several share a matching thread. For
+// stop orders price is the limit and stopPrice the trigger; a positive
+// displayQuantity makes a GTC, GTD or DAY add an iceberg and is ignored
+// for other types. expireTime is the expiry of a GTD add.
+struct Command {
+  CommandType type = CommandType::Add;
+  orderType tif = orderType::GTC;
+  bool isBuy = false;
+  uint32_t instrument = 0;
+  int id = 0;
+  int quantity = 0;
+  int displayQuantity = 0;
+  Price price;
+  Price stopPrice;
+  long long userId = 0;
+  long long timestamp = 0;
+  long long expireTime = NoExpiry;
+
+  static Command add(int id, Price price, int quantity, bool isBuy, long long userId, orderType tif = orderType::GTC) {
+    Command command;
+    command.type = CommandType::Add;
+    command.tif = tif;
+    command.isBuy = isBuy;
+    command.id = id;
+    command.quantity = quantity;
+    command.price = price;
+    command.userId = userId;
+    return command;
+  }
+
+  static Command stop(int id, Price stopPrice, Price limitPrice, int quantity, bool isBuy, long long userId, orderType type = orderType::STOP) {
+    Command command = add(id, limitPrice, quantity, isBuy, userId, type);
+    command.stopPrice = stopPrice;
+    return command;
+  }
+
+  static Command iceberg(int id, Price price, int quantity, int displayQuantity, bool isBuy, long long userId) {
+    Command command = add(id, price, quantity, isBuy, userId);
+    command.displayQuantity = displayQuantity;
+    return command;
+  }
+
+  static Command goodTillDate(int id, Price price, int quantity, bool isBuy, long long userId, long long expireTime) {
+    Command command = add(id, price, quantity, isBuy, userId, orderType::GTD);
+    command.expireTime = expireTime;
+    return command;
+  }
+
+  static Command cancel(int id) {
+    Command command;
+    command.type = CommandType::Cancel;
+    command.id = id;
+    return command;
+  }
+
+  static Command modify(int id, Price newPrice, int newQuantity) {
+    Command command;
+    command.type = CommandType::Modify;
+    command.id = id;
+    command.quantity = newQuantity;
+    command.price = newPrice;
+    return command;
+  }
+
+  // Advances the book to its clock's time, which on a matching thread or in
+  // a replay is this command's timestamp.
+  static Command advanceTime(long long timestamp) {
+    Command command;
+    command.type = CommandType::AdvanceTime;
+    command.timestamp = timestamp;
+    return command;
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<Command>, "Command must be trivially copyable");
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "FlatMap.h"
+#include "Price.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Aggregated state of one price level.
+struct DepthLevel {
+  Price price;
+  long long quantity = 0;
+  int orderCount = 0;
+};
+
+// Best bid and ask; a side with no orders has orderCount 0.
+struct TopOfBook {
+  DepthLevel bid;
+  DepthLevel ask;
+};
+
+// New aggregate of a level that changed; quantity 0 means it was deleted.
+struct LevelDelta {
+  Price price;
+  long long quantity = 0;
+  int orderCount = 0;
+  bool isBuy = false;
+};
+
+// Collects level deltas emitted by an OrderBook into a buffer sized up front,
+// so publishing never allocates on the match path. With conflation on, a
+// level that changes several times between drains keeps a single entry
+// holding its latest state, in the order the level first changed.
+//
+// If more deltas arrive than the buffer holds, the extra ones are dropped
+// and overflowed() reports it; the consumer should then rebuild from
+// OrderBook::depth(). The feed is owned by the book's thread.
+class DepthFeed {
+private:
+  std::vector<LevelDelta> pending;
+  size_t count = 0;
+  bool conflate;
+  bool dropped = false;
+  FlatMap<long long, uint32_t> slots;  // level key -> index in pending
+
+  static long long keyOf(bool isBuy, Price price) { return price.value * 2 + (isBuy ? 1 : 0); }
+
+public:
+  explicit DepthFeed(size_t capacity = 4096, bool conflate_ = true)
+    : pending(capacity), conflate(conflate_), slots(conflate_ ? capacity + 1 : 0) {}
+
+  void onLevel(bool isBuy, Price price, long long quantity, int orderCount) {
+    if (conflate) {
+      bool inserted = false;
+      uint32_t& slot = slots.findOrInsert(keyOf(isBuy, price), inserted);
+      if (!inserted) {
+        pending[slot].quantity = quantity;
+        pending[slot].orderCount = orderCount;
+        return;
+      }
+      if (count == pending.size()) {
+        slots.erase(keyOf(isBuy, price));
+        dropped = true;
+        return;
+      }
+      slot = static_cast<uint32_t>(count);
+    } else if (count == pending.size()) {
+      dropped = true;
+      return;
+    }
+    pending[count++] = LevelDelta{price, quantity, orderCount, isBuy};
+  }
+
+  size_t size() const { return count; }
+  bool overflowed() const { return dropped; }
+  const LevelDelta* begin() const { return pending.data(); }
+  const LevelDelta* end() const { return pending.data() + count; }
+
+  // Forgets the pending deltas and the overflow flag once they are consumed.
+  void clear() {
+    if (conflate) {
+      for (size_t i = 0; i < count; ++i) slots.erase(keyOf(pending[i].isBuy, pending[i].price));
+    }
+    count = 0;
+    dropped = false;
+  }
+
+  // Hands every pending delta to fn, then clears. Returns how many there were.
+  template <typename F>
+  size_t drain(F&& fn) {
+    size_t n = count;
+    for (size_t i = 0; i < n; ++i) fn(pending[i]);
+    clear();
+    return n;
+  }
+};
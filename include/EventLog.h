@@ -0,0 +1,104 @@
+#pragma once
+
+#include "ExecutionReport.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Binary event log: an EventLogHeader followed by ExecutionReport records in
+// native byte order, in the order the book emitted them.
+struct EventLogHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+// Writes ExecutionReports to a binary event log off the producing thread.
+// log() only copies the record into an SPSC ring, so the matching thread
+// never formats text or makes a system call. A background thread drains the
+// ring into a page-aligned buffer and writes it out when it fills, so under
+// load the file grows in large writes; when the ring goes quiet, a partial
+// buffer is written once flushInterval has passed since the last write.
+//
+// The log is lossless: if the ring is full, log() waits for the writer and
+// counts a stall. Only one thread may call log().
+class EventLogWriter {
+public:
+  struct Config {
+    size_t ringCapacity = 1 << 16;       // records; must be a power of two
+    size_t bufferBytes = 1 << 20;        // size of each write under load
+    long long flushIntervalMicros = 1000;
+    int core = -1;                       // CPU to pin the writer to; -1 leaves it unpinned
+  };
+
+private:
+  Config config;
+  int fd = -1;
+  SpscRing<ExecutionReport> ring;
+  ExecutionReport* buffer = nullptr;
+  size_t bufferRecords = 0;
+  std::thread writer;
+  std::atomic<bool> running{false};
+  std::atomic<bool> writeFailed{false};
+  alignas(CacheLineSize) std::atomic<unsigned long long> writtenCount{0};
+  alignas(CacheLineSize) unsigned long long stallCount = 0;
+
+  void run();
+  bool writeAll(const void* data, size_t bytes);
+  void logSlow(const ExecutionReport& report);
+
+public:
+  // Creates path, replacing any existing file, and starts the writer thread.
+  // Throws std::runtime_error if the file cannot be created.
+  explicit EventLogWriter(const std::string& path);
+  EventLogWriter(const std::string& path, const Config& config_);
+  EventLogWriter(const EventLogWriter&) = delete;
+  EventLogWriter& operator=(const EventLogWriter&) = delete;
+  ~EventLogWriter();
+
+  void log(const ExecutionReport& report) {
+    if (!ring.tryPush(report)) logSlow(report);
+  }
+
+  // Writes everything logged so far, stops the writer and closes the file.
+  // log() must not be called afterwards.
+  void close();
+
+  // Records on disk so far.
+  unsigned long long written() const { return writtenCount.load(std::memory_order_acquire); }
+  // Times log() found the ring full; read from the logging thread.
+  unsigned long long stalls() const { return stallCount; }
+  // True if a write to the file failed; later records were discarded.
+  bool failed() const { return writeFailed.load(std::memory_order_acquire); }
+};
+
+// ReportSink publisher that sends each report to an event log.
+struct LogReports {
+  EventLogWriter* log;
+  void operator()(const ExecutionReport& report) const { log->log(report); }
+};
+
+// Read-only view of an event log, mapped in one piece. A partial record at
+// the end, left by a crash mid-write, is ignored.
+class EventLogReader {
+private:
+  int fd = -1;
+  char* base = nullptr;
+  size_t mappedBytes = 0;
+  const ExecutionReport* first = nullptr;
+  size_t count = 0;
+
+public:
+  // Throws std::runtime_error if path is missing or not an event log.
+  explicit EventLogReader(const std::string& path);
+  EventLogReader(const EventLogReader&) = delete;
+  EventLogReader& operator=(const EventLogReader&) = delete;
+  ~EventLogReader();
+
+  size_t size() const { return count; }
+  const ExecutionReport& operator[](size_t i) const { return first[i]; }
+  const ExecutionReport* begin() const { return first; }
+  const ExecutionReport* end() const { return first + count; }
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ExecutionSink.h"
+#include "Price.h"
+#include "Trade.h"
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+enum struct ReportType : uint8_t {
+  Accepted,
+  Trade,
+  Rested,
+  Cancelled,
+  Modified
+};
+
+// Fixed-size outbound record for one ExecutionSink event. For trades, id is
+// the aggressive order and contraId the passive one.
+struct ExecutionReport {
+  ReportType type = ReportType::Accepted;
+  bool isBuy = false;
+  uint32_t instrument = 0;
+  int id = 0;
+  int contraId = 0;
+  int quantity = 0;
+  Price price;
+  long long userId = 0;
+  long long timestamp = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<ExecutionReport>, "ExecutionReport must be trivially copyable");
+
+// Turns sink callbacks into ExecutionReport records and hands each one to
+// publish(const ExecutionReport&). timestamp and instrument are stamped on
+// every report.
+template <typename Publish>
+class ReportSink : public ExecutionSink {
+private:
+  Publish publish;
+
+  ExecutionReport make(ReportType type, int id, Price price, int quantity) const {
+    ExecutionReport report;
+    report.type = type;
+    report.id = id;
+    report.price = price;
+    report.quantity = quantity;
+    report.instrument = instrument;
+    report.timestamp = timestamp;
+    return report;
+  }
+
+public:
+  long long timestamp = 0;
+  uint32_t instrument = 0;
+
+  explicit ReportSink(Publish publish_) : publish(publish_) {}
+
+  void onAccepted(int id, Price price, int quantity, bool isBuy, long long userId) override {
+    ExecutionReport report = make(ReportType::Accepted, id, price, quantity);
+    report.isBuy = isBuy;
+    report.userId = userId;
+    publish(report);
+  }
+
+  void onTrade(const Trade& trade) override {
+    ExecutionReport report = make(ReportType::Trade, static_cast<int>(trade.agressiveId), trade.price, trade.quantity);
+    report.contraId = static_cast<int>(trade.passiveId);
+    publish(report);
+  }
+
+  void onRested(int id, Price price, int quantity) override { publish(make(ReportType::Rested, id, price, quantity)); }
+  void onCancelled(int id, int quantity) override { publish(make(ReportType::Cancelled, id, Price(), quantity)); }
+  void onModified(int id, int newQuantity) override { publish(make(ReportType::Modified, id, Price(), newQuantity)); }
+};
+
+// Publisher that appends to a caller-owned vector; reserved up front, it
+// collects a whole batch of results contiguously without allocating.
+struct AppendReports {
+  std::vector<ExecutionReport>* out;
+  void operator()(const ExecutionReport& report) const { out->push_back(report); }
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Price.h"
+#include "Trade.h"
+#include <vector>
+
+// Receives the book's events as they happen, one call per event, so callers
+// decide whether to stream, aggregate or drop them. Every handler defaults to
+// a no-op. A repriced or enlarged modify is reported as a cancel followed by
+// a fresh acceptance.
+class ExecutionSink {
+public:
+  virtual ~ExecutionSink() = default;
+
+  // The order passed validation and is about to match.
+  virtual void onAccepted(int /*id*/, Price /*price*/, int /*quantity*/, bool /*isBuy*/, long long /*userId*/) {}
+  virtual void onTrade(const Trade& /*trade*/) {}
+  // The unfilled remainder of the order is now resting in the book.
+  virtual void onRested(int /*id*/, Price /*price*/, int /*quantity*/) {}
+  // quantity is what was taken out of the book or, for IOC/FOK, left unfilled.
+  virtual void onCancelled(int /*id*/, int /*quantity*/) {}
+  // A same-price reduction kept the order's place in the queue.
+  virtual void onModified(int /*id*/, int /*newQuantity*/) {}
+};
+
+// Drops every event.
+class NullSink : public ExecutionSink {};
+
+// Adapter for the vector-based API: collects trades and ignores the rest.
+class TradeVectorSink : public ExecutionSink {
+private:
+  std::vector<Trade>& trades;
+
+public:
+  explicit TradeVectorSink(std::vector<Trade>& trades_) : trades(trades_) {}
+
+  void onTrade(const Trade& trade) override { trades.push_back(trade); }
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "Order.h"
+#include <cstdint>
+#include <limits>
+#include <memory>
+
+// Pending expiries of resting orders, kept in a hierarchical timing wheel
+// over ticks of `resolution` time units. Level 0 holds the 64 ticks of the
+// current block, level 1 the 64 blocks of the current 64^2 ticks, and so on;
+// expiries past the top level wait on an overflow list. An expiry is filed
+// at the level of the highest 6-bit digit in which its tick differs from
+// the current tick, and when the wheel enters a slot's span that slot is
+// redistributed to lower levels. An order is therefore moved at most once
+// per level: scheduling, cancelling and expiring are amortized O(1). Empty
+// stretches are skipped by jumping to the next occupied slot.
+//
+// Ticks only bucket the work. An order expires on the first advance() whose
+// time has reached its expireTime, and orders that fall due in the same
+// tick expire in the order they were scheduled.
+class ExpiryWheel {
+private:
+  static constexpr int SlotBits = 6;
+  static constexpr int SlotsPerLevel = 1 << SlotBits;
+  static constexpr int Levels = 6;
+  static constexpr unsigned long long SlotMask = SlotsPerLevel - 1;
+  static constexpr int OverflowSlot = Levels * SlotsPerLevel;
+  static constexpr int Unscheduled = -1;
+
+  struct Slot {
+    OrderDetails* head = nullptr;
+    OrderDetails* tail = nullptr;
+  };
+
+  long long resolution;
+  long long now = 0;
+  unsigned long long current = 0;
+  // Allocated on the first schedule, so books without expiring orders stay small.
+  std::unique_ptr<Slot[]> slots;
+  uint64_t occupied[Levels] = {};
+  // Smallest tick on the overflow list.
+  unsigned long long overflowFirst = std::numeric_limits<unsigned long long>::max();
+  size_t count = 0;
+
+  unsigned long long tickOf(long long time) const { return time <= 0 ? 0 : static_cast<unsigned long long>(time / resolution); }
+
+  int slotFor(unsigned long long tick) {
+    unsigned long long diff = tick ^ current;
+    int level = diff ? (63 - __builtin_clzll(diff)) / SlotBits : 0;
+    if (level >= Levels) {
+      if (tick < overflowFirst) overflowFirst = tick;
+      return OverflowSlot;
+    }
+    return level * SlotsPerLevel + static_cast<int>((tick >> (level * SlotBits)) & SlotMask);
+  }
+
+  void link(OrderDetails* node, int index) {
+    Slot& slot = slots[index];
+    node->timerPrev = slot.tail;
+    node->timerNext = nullptr;
+    if (slot.tail) slot.tail->timerNext = node;
+    else slot.head = node;
+    slot.tail = node;
+    node->timerSlot = index;
+    if (index < OverflowSlot) occupied[index / SlotsPerLevel] |= 1ull << (index % SlotsPerLevel);
+  }
+
+  void unlink(OrderDetails* node) {
+    Slot& slot = slots[node->timerSlot];
+    if (node->timerPrev) node->timerPrev->timerNext = node->timerNext;
+    else slot.head = node->timerNext;
+    if (node->timerNext) node->timerNext->timerPrev = node->timerPrev;
+    else slot.tail = node->timerPrev;
+    if (!slot.head && node->timerSlot < OverflowSlot) {
+      occupied[node->timerSlot / SlotsPerLevel] &= ~(1ull << (node->timerSlot % SlotsPerLevel));
+    }
+    node->timerPrev = node->timerNext = nullptr;
+    node->timerSlot = Unscheduled;
+  }
+
+  // Refiles every expiry in a slot relative to the current tick.
+  void redistribute(int index) {
+    Slot& slot = slots[index];
+    OrderDetails* node = slot.head;
+    slot = Slot{};
+    if (index < OverflowSlot) occupied[index / SlotsPerLevel] &= ~(1ull << (index % SlotsPerLevel));
+    else overflowFirst = std::numeric_limits<unsigned long long>::max();
+    while (node) {
+      OrderDetails* next = node->timerNext;
+      link(node, slotFor(tickOf(node->expireTime)));
+      node = next;
+    }
+  }
+
+  // The next tick the wheel has to stop at on its way to target: the start
+  // of the earliest occupied slot above level 0, or target itself.
+  unsigned long long nextStop(unsigned long long target) const {
+    unsigned long long next = target;
+    for (int level = 1; level < Levels; ++level) {
+      if (!occupied[level]) continue;
+      int shift = level * SlotBits;
+      unsigned long long start = (current >> (shift + SlotBits) << (shift + SlotBits)) |
+                                 (static_cast<unsigned long long>(__builtin_ctzll(occupied[level])) << shift);
+      if (start < next) next = start;
+    }
+    if (slots[OverflowSlot].head) {
+      unsigned long long start = overflowFirst >> (Levels * SlotBits) << (Levels * SlotBits);
+      if (start < next) next = start;
+    }
+    return next;
+  }
+
+  // Called after current moved: slots whose span now holds it come down a level.
+  void cascade() {
+    if (slots[OverflowSlot].head && (current >> (Levels * SlotBits)) == (overflowFirst >> (Levels * SlotBits))) {
+      redistribute(OverflowSlot);
+    }
+    for (int level = Levels - 1; level > 0; --level) {
+      int index = static_cast<int>((current >> (level * SlotBits)) & SlotMask);
+      if (occupied[level] & (1ull << index)) redistribute(level * SlotsPerLevel + index);
+    }
+  }
+
+  template <typename Expire>
+  void expireSlot(int index, Expire& expire) {
+    OrderDetails* node = slots[index].head;
+    while (node) {
+      OrderDetails* next = node->timerNext;
+      if (node->expireTime <= now) {
+        unlink(node);
+        --count;
+        expire(node);
+      }
+      node = next;
+    }
+  }
+
+public:
+  explicit ExpiryWheel(long long resolution_ = 1 << 20) : resolution(resolution_ > 0 ? resolution_ : 1) {}
+
+  // Time of the last advance().
+  long long time() const { return now; }
+  size_t size() const { return count; }
+  bool scheduled(const OrderDetails* node) const { return node->timerSlot != Unscheduled; }
+
+  // Moves an empty wheel to time without expiring anything, e.g. before
+  // reloading a saved book.
+  void reset(long long time) {
+    now = time;
+    current = tickOf(time);
+  }
+
+  // Files node under node->expireTime. An expiry already due fires on the
+  // next advance().
+  void schedule(OrderDetails* node) {
+    if (!slots) slots.reset(new Slot[OverflowSlot + 1]);
+    unsigned long long tick = tickOf(node->expireTime);
+    link(node, slotFor(tick < current ? current : tick));
+    ++count;
+  }
+
+  void cancel(OrderDetails* node) {
+    if (node->timerSlot == Unscheduled) return;
+    unlink(node);
+    --count;
+  }
+
+  // Moves the wheel to time and calls expire(node) for every node due by
+  // then. Each node is unscheduled before its callback runs, which may
+  // cancel or free it but must not touch other scheduled nodes. Time never
+  // moves backwards; an earlier time is ignored.
+  template <typename Expire>
+  void advance(long long time, Expire&& expire) {
+    if (time <= now) return;
+    now = time;
+    unsigned long long target = tickOf(time);
+    if (count == 0) {
+      current = target;
+      return;
+    }
+
+    for (;;) {
+      bool lastBlock = (target >> SlotBits) == (current >> SlotBits);
+      unsigned long long first = current & SlotMask;
+      unsigned long long last = lastBlock ? target & SlotMask : SlotMask;
+      uint64_t due = occupied[0] >> first << first;
+      if (last < SlotMask) due &= (2ull << last) - 1;
+      while (due) {
+        int slot = __builtin_ctzll(due);
+        due &= due - 1;
+        expireSlot(slot, expire);
+      }
+      if (lastBlock) {
+        current = target;
+        return;
+      }
+      current = nextStop(target);
+      cascade();
+    }
+  }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// Open-addressing hash map for integral keys. Fibonacci hashing spreads
+// sequential keys across the table, and linear probing with backward-shift
+// deletion keeps it free of tombstones, so a lookup is one short probe over
+// a flat array. EmptyKey marks unused slots, so an entry under that key is
+// kept beside the table instead of in it.
+template <typename Key, typename Value, Key EmptyKey = std::numeric_limits<Key>::min()>
+class FlatMap {
+  static_assert(std::is_integral_v<Key>, "FlatMap keys must be integral");
+
+private:
+  struct Slot {
+    Key key;
+    Value value;
+  };
+
+  std::vector<Slot> slots;
+  size_t count = 0;
+  int shift = 64;
+  bool hasEmptyKey = false;
+  Value emptyKeyValue{};
+
+  size_t home(Key key) const {
+    return static_cast<size_t>((static_cast<uint64_t>(key) * 11400714819323198485ull) >> shift);
+  }
+
+  size_t mask() const { return slots.size() - 1; }
+
+  void rehash(size_t capacity) {
+    std::vector<Slot> old(capacity, Slot{EmptyKey, Value()});
+    old.swap(slots);
+    shift = 64 - __builtin_ctzll(capacity);
+    count = hasEmptyKey;
+    for (Slot& slot : old) {
+      if (slot.key != EmptyKey) *insertSlot(slot.key) = std::move(slot.value);
+    }
+  }
+
+  // Returns the value slot for a key that is known to be absent.
+  Value* insertSlot(Key key) {
+    size_t i = home(key);
+    while (slots[i].key != EmptyKey) i = (i + 1) & mask();
+    slots[i].key = key;
+    ++count;
+    return &slots[i].value;
+  }
+
+public:
+  // The table is allocated on first insert unless a capacity is given.
+  explicit FlatMap(size_t capacity = 0) {
+    if (capacity) reserve(capacity);
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  size_t capacity() const { return slots.size(); }
+  size_t memoryUsage() const { return slots.capacity() * sizeof(Slot); }
+
+  // Grows the table so that n entries fit under the maximum load factor.
+  void reserve(size_t n) {
+    size_t capacity = 16;
+    while (capacity < n * 2) capacity <<= 1;
+    if (capacity > slots.size()) rehash(capacity);
+  }
+
+  // Returned by prefetch() when there is no slot to fetch.
+  static constexpr size_t NoSlot = std::numeric_limits<size_t>::max();
+
+  // Pulls the home slot of key into cache ahead of a find() and returns its
+  // position for findAt().
+  size_t prefetch(Key key) const {
+    if (slots.empty()) return NoSlot;
+    size_t i = home(key);
+    __builtin_prefetch(&slots[i]);
+    return i;
+  }
+
+  // Looks only at slot, typically one prefetch() returned: the value if key
+  // is there, else nullptr. Never probes, so a key displaced by a collision,
+  // a rehash or an erase since then is simply not found.
+  const Value* findAt(size_t slot, Key key) const {
+    if (key == EmptyKey || slot >= slots.size() || slots[slot].key != key) return nullptr;
+    return &slots[slot].value;
+  }
+
+  Value* find(Key key) {
+    if (key == EmptyKey) return hasEmptyKey ? &emptyKeyValue : nullptr;
+    if (slots.empty()) return nullptr;
+    for (size_t i = home(key);; i = (i + 1) & mask()) {
+      Slot& slot = slots[i];
+      if (slot.key == key) return &slot.value;
+      if (slot.key == EmptyKey) return nullptr;
+    }
+  }
+
+  const Value* find(Key key) const { return const_cast<FlatMap*>(this)->find(key); }
+
+  // Inserts a default-constructed value if key is absent; inserted reports which.
+  Value& findOrInsert(Key key, bool& inserted) {
+    if (Value* value = find(key)) {
+      inserted = false;
+      return *value;
+    }
+    inserted = true;
+    if (key == EmptyKey) {
+      hasEmptyKey = true;
+      ++count;
+      return emptyKeyValue;
+    }
+    if ((count + 1) * 2 > slots.size()) rehash(slots.empty() ? 16 : slots.size() * 2);
+    return *insertSlot(key);
+  }
+
+  Value& operator[](Key key) {
+    bool inserted;
+    return findOrInsert(key, inserted);
+  }
+
+  // Removes key, moving its value into removed. Returns false if absent.
+  bool erase(Key key, Value* removed = nullptr) {
+    if (key == EmptyKey) {
+      if (!hasEmptyKey) return false;
+      if (removed) *removed = std::move(emptyKeyValue);
+      emptyKeyValue = Value();
+      hasEmptyKey = false;
+      --count;
+      return true;
+    }
+    if (slots.empty()) return false;
+    size_t i = home(key);
+    for (;; i = (i + 1) & mask()) {
+      if (slots[i].key == key) break;
+      if (slots[i].key == EmptyKey) return false;
+    }
+    if (removed) *removed = std::move(slots[i].value);
+
+    // Shift later members of the probe chain back into the hole.
+    for (size_t j = (i + 1) & mask();; j = (j + 1) & mask()) {
+      if (slots[j].key == EmptyKey) break;
+      size_t h = home(slots[j].key);
+      bool movable = i <= j ? (h <= i || h > j) : (h <= i && h > j);
+      if (movable) {
+        slots[i] = std::move(slots[j]);
+        i = j;
+      }
+    }
+    slots[i] = Slot{EmptyKey, Value()};
+    --count;
+    return true;
+  }
+
+  template <typename F>
+  void forEach(F f) const {
+    if (hasEmptyKey) f(EmptyKey, emptyKeyValue);
+    for (const Slot& slot : slots) {
+      if (slot.key != EmptyKey) f(slot.key, slot.value);
+    }
+  }
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Command.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class ExecutionSink;
+class OrderBook;
+
+// On-disk layout: a JournalHeader followed by fixed-size JournalRecords in
+// native byte order. Sequence numbers start at 1 and increase by one, and
+// each record carries a checksum of its other bytes. A reader stops at the
+// first record that breaks the run or fails its checksum, which covers both
+// the zeroed preallocated tail and a record torn by a crash.
+struct JournalHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+};
+
+struct JournalRecord {
+  unsigned long long sequence;
+  Command command;
+  unsigned long long checksum;
+};
+
+static_assert(std::is_trivially_copyable_v<JournalRecord>, "JournalRecord is written as raw bytes");
+
+// Append-only, mmap-backed command journal. Records are copied straight into
+// the mapping, which grows in large steps, and made durable by commit():
+// one msync covers every record appended since the previous commit, so a
+// batch of commands costs a single sync. commit() also runs automatically
+// every groupCommit records.
+class JournalWriter {
+public:
+  struct Config {
+    size_t groupCommit = 1024;  // records between automatic commits; 0 commits only on request
+    bool sync = true;           // false leaves write-back to the OS
+    size_t growBytes = 64 << 20;
+  };
+
+private:
+  Config config;
+  int fd = -1;
+  char* base = nullptr;
+  size_t mappedBytes = 0;
+  size_t writtenBytes = 0;
+  size_t committedBytes = 0;
+  unsigned long long nextSequence = 1;
+
+  void grow();
+
+public:
+  // Creates path, replacing any existing file. Throws std::runtime_error if
+  // the file cannot be created or mapped.
+  explicit JournalWriter(const std::string& path);
+  JournalWriter(const std::string& path, const Config& config_);
+  JournalWriter(const JournalWriter&) = delete;
+  JournalWriter& operator=(const JournalWriter&) = delete;
+  // Commits and trims the file to the records actually written.
+  ~JournalWriter();
+
+  // Returns the sequence number assigned to the record.
+  unsigned long long append(const Command& command);
+  void commit();
+
+  unsigned long long records() const { return nextSequence - 1; }
+};
+
+// Read-only view of a journal, mapped in one piece.
+class JournalReader {
+private:
+  int fd = -1;
+  char* base = nullptr;
+  size_t mappedBytes = 0;
+  const JournalRecord* first = nullptr;
+  size_t count = 0;
+
+public:
+  // Throws std::runtime_error if path is missing or not a journal.
+  explicit JournalReader(const std::string& path);
+  JournalReader(const JournalReader&) = delete;
+  JournalReader& operator=(const JournalReader&) = delete;
+  ~JournalReader();
+
+  size_t size() const { return count; }
+  const JournalRecord& operator[](size_t i) const { return first[i]; }
+  const JournalRecord* begin() const { return first; }
+  const JournalRecord* end() const { return first + count; }
+};
+
+// Streams the records after afterSequence into book, driving its clock from
+// the recorded timestamps. Starting from an empty book (or from a snapshot
+// taken at afterSequence), trades come out exactly as they did originally,
+// provided that run clocked the book the same way, as MatchingThread does.
+// The book is left without a clock. Instruments are ignored: every record
+// goes to book. Returns the number of commands applied.
+size_t replayJournal(const JournalReader& journal, OrderBook& book, ExecutionSink& sink, unsigned long long afterSequence = 0);
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Log-linear latency histogram in the style of HdrHistogram. Values below
+// 2^SubBucketBits nanoseconds are counted exactly; above that, every power
+// of two is split into 2^(SubBucketBits - 1) equal buckets, so any recorded
+// value is reported within 1/64 (about 1.6%) of its true value. Recording
+// is a couple of shifts and an increment into a fixed array, cheap enough
+// to run around every operation of a benchmark. Values above ~18 minutes
+// are clamped.
+class LatencyHistogram {
+private:
+  static constexpr int SubBucketBits = 7;
+  static constexpr int SubBucketHalf = 1 << (SubBucketBits - 1);
+  static constexpr int MaxBits = 40;
+  static constexpr int BucketCount = (MaxBits - SubBucketBits + 2) * SubBucketHalf;
+
+  long long counts[BucketCount];
+  long long total = 0;
+  long long largest = 0;
+  double sum = 0;
+
+  static int indexOf(uint64_t value) {
+    if (value < (1ull << SubBucketBits)) return static_cast<int>(value);
+    int shift = 63 - __builtin_clzll(value) - (SubBucketBits - 1);
+    return (shift + 1) * SubBucketHalf + static_cast<int>(value >> shift) - SubBucketHalf;
+  }
+
+  // Largest value that lands in bucket index.
+  static long long highestIn(int index) {
+    if (index < (1 << SubBucketBits)) return index;
+    int shift = index / SubBucketHalf - 1;
+    long long sub = index % SubBucketHalf + SubBucketHalf;
+    return ((sub + 1) << shift) - 1;
+  }
+
+public:
+  LatencyHistogram() { reset(); }
+
+  void record(long long nanoseconds) {
+    uint64_t value = static_cast<uint64_t>(std::max(0LL, std::min(nanoseconds, (1LL << MaxBits) - 1)));
+    ++counts[indexOf(value)];
+    ++total;
+    sum += static_cast<double>(value);
+    if (static_cast<long long>(value) > largest) largest = static_cast<long long>(value);
+  }
+
+  long long count() const { return total; }
+  long long max() const { return largest; }
+  double mean() const { return total ? sum / total : 0.0; }
+
+  // Smallest recorded value (to histogram precision) that at least
+  // percent% of the samples do not exceed; percent is in [0, 100].
+  long long percentile(double percent) const {
+    if (!total) return 0;
+    long long rank = std::max(1LL, static_cast<long long>(std::ceil(percent / 100.0 * total)));
+    long long seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+      seen += counts[i];
+      if (seen >= rank) return std::min(highestIn(i), largest);
+    }
+    return largest;
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BucketCount; ++i) counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    largest = std::max(largest, other.largest);
+  }
+
+  void reset() {
+    std::memset(counts, 0, sizeof(counts));
+    total = 0;
+    largest = 0;
+    sum = 0;
+  }
+};
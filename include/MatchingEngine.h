@@ -0,0 +1,86 @@
+#pragma once
+
+#include "FlatMap.h"
+#include "MatchingThread.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Maps order id -> instrument so cancels and amends reach the one shard that
+// holds the order. Ids below capacity live in a dense array of atomics that
+// every gateway thread reads and writes without locking; other ids fall back
+// to a mutex-guarded map. Instrument ids must be below UINT32_MAX.
+class OrderDirectory {
+private:
+  std::unique_ptr<std::atomic<uint32_t>[]> dense;  // instrument + 1, 0 if unknown
+  size_t denseSize;
+  mutable std::mutex overflowMutex;
+  FlatMap<int, uint32_t> overflow;
+
+  bool isDense(int id) const { return id >= 0 && static_cast<size_t>(id) < denseSize; }
+
+public:
+  explicit OrderDirectory(size_t capacity);
+
+  void insert(int id, uint32_t instrument);
+  bool find(int id, uint32_t& instrument) const;
+  void erase(int id);
+};
+
+// Runs many instruments across a fixed set of MatchingThreads. Each
+// instrument is owned by exactly one shard, chosen by hashing its id, so a
+// book is only ever touched by its shard's thread and needs no locks.
+//
+// Gateways submit Commands for any instrument through their own producer
+// slot. Adds carry the instrument and record it in the directory; cancels
+// and amends only carry the order id and are routed through the directory,
+// so no command is ever broadcast. AdvanceTime goes to its instrument's
+// shard. Entries for orders that later fill stay in the directory until the
+// id is cancelled or reused; routing to them is harmless because the book
+// ignores unknown ids.
+class MatchingEngine {
+public:
+  struct Config {
+    int shards = 1;
+    int producers = 1;
+    size_t inboundCapacity = 1 << 16;
+    size_t outboundCapacity = 1 << 18;
+    size_t directoryCapacity = 1 << 20;
+    int firstCore = -1;  // shard i is pinned to firstCore + i; -1 leaves them unpinned
+  };
+
+private:
+  Config config;
+  std::vector<std::unique_ptr<MatchingThread>> workers;
+  OrderDirectory directory;
+  size_t nextPoll = 0;
+
+public:
+  explicit MatchingEngine(const Config& config_);
+  MatchingEngine(const MatchingEngine&) = delete;
+  MatchingEngine& operator=(const MatchingEngine&) = delete;
+
+  // Registers an instrument on its shard; only valid before start().
+  bool addInstrument(uint32_t instrument, std::unique_ptr<OrderBook> book = std::make_unique<OrderBook>());
+  int shardOf(uint32_t instrument) const;
+  int shards() const { return static_cast<int>(workers.size()); }
+
+  void start();
+  void stop();
+
+  // Producer side; only the thread that owns producer may call it. Returns
+  // false if the target ring is full, or for a cancel or amend of an id the
+  // directory does not know.
+  bool submit(int producer, Command command);
+
+  // Consumer side; a single thread polls the reports of every shard.
+  bool poll(ExecutionReport& report);
+  size_t pollBatch(ExecutionReport* out, size_t max);
+
+  unsigned long long processed() const;
+
+  // Direct access to a book; only safe while the engine is stopped.
+  OrderBook* book(uint32_t instrument) { return workers[shardOf(instrument)]->book(instrument); }
+};
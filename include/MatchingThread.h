@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Clock.h"
+#include "Command.h"
+#include "ExecutionReport.h"
+#include "FlatMap.h"
+#include "Journal.h"
+#include "OrderBook.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Owns one or more OrderBooks and drives them from a dedicated (optionally
+// pinned) thread. Each gateway thread gets its own inbound SPSC ring of
+// Commands, and every book event is published as an ExecutionReport on a
+// single outbound SPSC ring. Commands pick their book by instrument; those
+// for an unknown instrument are dropped.
+//
+// The book's clock follows each command's ingress timestamp, so reports
+// and trades carry the time the gateway saw the command. With a journal
+// attached, each drained batch is appended and committed before any of it
+// is applied, which makes the journal a write-ahead log that replays to the
+// same trades.
+class MatchingThread {
+public:
+  struct Config {
+    int producers = 1;
+    size_t inboundCapacity = 1 << 16;
+    size_t outboundCapacity = 1 << 18;
+    int core = -1;  // CPU to pin the matching thread to; -1 leaves it unpinned
+  };
+
+private:
+  Config config;
+  std::vector<std::unique_ptr<OrderBook>> ownedBooks;
+  FlatMap<uint32_t, OrderBook*, std::numeric_limits<uint32_t>::max()> books;
+  ManualClock clock;
+  JournalWriter* journal = nullptr;
+
+  struct SnapshotRequest {
+    uint32_t instrument;
+    std::vector<char>* out;
+    std::atomic<bool> done{false};
+  };
+  std::atomic<SnapshotRequest*> pendingSnapshot{nullptr};
+
+  std::vector<std::unique_ptr<SpscRing<Command>>> inbound;
+  SpscRing<ExecutionReport> outbound;
+  std::thread thread;
+  std::atomic<bool> running{false};
+  alignas(CacheLineSize) std::atomic<unsigned long long> processedCount{0};
+
+  void run();
+  void serveSnapshot();
+  void publish(const ExecutionReport& report);
+
+public:
+  // A non-null book is registered as instrument 0.
+  explicit MatchingThread(const Config& config_, std::unique_ptr<OrderBook> book = std::make_unique<OrderBook>());
+  MatchingThread(const MatchingThread&) = delete;
+  MatchingThread& operator=(const MatchingThread&) = delete;
+  ~MatchingThread();
+
+  // Registers a book for instrument; only valid before start(). Returns
+  // false if the instrument already has one.
+  bool addBook(uint32_t instrument, std::unique_ptr<OrderBook> book);
+
+  // Journals every command from now on; only valid before start().
+  void setJournal(JournalWriter* journal_) { journal = journal_; }
+
+  void start();
+  // Processes every command already queued, then joins the thread. The
+  // outbound ring must be drained meanwhile if it can fill up.
+  void stop();
+
+  // Copies an instrument's book into out (see OrderBook::saveSnapshot). While
+  // the thread runs, the copy is handed off to it and taken between two
+  // batches, so matching only pauses for the in-memory copy and the caller
+  // does any I/O afterwards. Blocks until the image is ready; must not race
+  // start() or stop(). Returns false for an unknown instrument.
+  bool snapshot(uint32_t instrument, std::vector<char>& out);
+
+  // Producer side; only the thread that owns producer may call it.
+  bool submit(int producer, const Command& command) { return inbound[producer]->tryPush(command); }
+
+  // Consumer side; a single thread polls execution reports.
+  bool poll(ExecutionReport& report) { return outbound.tryPop(report); }
+  size_t pollBatch(ExecutionReport* out, size_t max) { return outbound.popBatch(out, max); }
+
+  unsigned long long processed() const { return processedCount.load(std::memory_order_acquire); }
+
+  // Direct access to a book; only safe while the thread is stopped. Returns
+  // nullptr for an unknown instrument.
+  OrderBook* book(uint32_t instrument) {
+    OrderBook** found = books.find(instrument);
+    return found ? *found : nullptr;
+  }
+  OrderBook& book() { return *book(0); }
+};
+
+// Pins the calling thread to core (no-op where affinity is unsupported).
+void pinCurrentThread(int core);
+// Busy-wait hint for spin loops; yields after the first few hundred spins.
+void idleSpin(unsigned& spins);
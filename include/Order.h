@@ -1,22 +1,54 @@
 #pragma once
 
+#include "CacheLine.h"
+#include "OrderType.h"
 #include <Price.h>
 
-struct Order {
+struct Order;
+struct PriceLevel;
+
+// Fields of a resting order that matching never reads: the owner's list
+// links, the expiry, the entry time and the iceberg slice size.
+struct OrderDetails {
+  Order* order = nullptr;
+  // Intrusive links into the list of the owner's resting orders.
+  OrderDetails* userPrev = nullptr;
+  OrderDetails* userNext = nullptr;
+  // Intrusive links into an ExpiryWheel slot, for GTD and DAY orders.
+  OrderDetails* timerPrev = nullptr;
+  OrderDetails* timerNext = nullptr;
+  long long timestamp = 0;
+  long long expireTime = NoExpiry;
+  // Iceberg slice size, 0 for a plain order.
+  int displayQuantity = 0;
+  // ExpiryWheel slot holding the order, -1 while unscheduled.
+  int timerSlot = -1;
+};
+
+// A resting order as the match loop sees it, packed into one cache line:
+// walking a queue, trading, checking the owner and unlinking a filled order
+// each touch a single line per order. The rest lives in OrderDetails.
+struct alignas(CacheLineSize) Order {
+  // Intrusive links into the FIFO queue of the owning price level.
+  Order* prev = nullptr;
+  Order* next = nullptr;
+  PriceLevel* level = nullptr;
+  OrderDetails* details;
+  long long userId;
+  // Arrival sequence assigned by the book; strictly increasing.
+  unsigned long long sequence = 0;
   int id;
-  Price price;
+  // Visible quantity; for an iceberg, the current slice.
   int quantity;
-  long long timestamp;
-  long long userId;
+  // Iceberg reserve not yet shown in the book.
+  int hiddenQuantity = 0;
+  bool isBuy;
 
-  Order(int id_, double price_, int quantity_, long long timestamp_, long long userId_) 
-    : id(id_), price(price_), quantity(quantity_), timestamp(timestamp_), userId(userId_) {}
+  Order(int id_, int quantity_, long long userId_, bool isBuy_, OrderDetails* details_)
+    : details(details_), userId(userId_), id(id_), quantity(quantity_), isBuy(isBuy_) {}
 
-  Order(int id_, Price price_, int quantity_, long long timestamp_, long long userId_)
-    : id(id_), price(price_), quantity(quantity_), timestamp(timestamp_), userId(userId_) {}
+  // A resting order's price is its level's.
+  Price price() const;
+};
 
-  bool operator<(const Order& other) const {
-    if (timestamp != other.timestamp) return timestamp < other.timestamp;
-    return id < other.id;
-  }
-};
\ No newline at end of file
+static_assert(sizeof(Order) == CacheLineSize, "Order must fill exactly one cache line");
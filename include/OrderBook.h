@@ -1,32 +1,241 @@
 #pragma once
 
+#include "AllocationPolicy.h"
+#include "BookSide.h"
+#include "Clock.h"
+#include "Command.h"
+#include "DepthFeed.h"
+#include "ExecutionSink.h"
+#include "ExpiryWheel.h"
+#include "FlatMap.h"
 #include "Order.h"
+#include "OrderIndex.h"
+#include "OrderType.h"
+#include "PriceLadder.h"
+#include "PriceLevel.h"
+#include "Seqlock.h"
+#include "SelfTradePrevention.h"
+#include "StopBook.h"
 #include "Trade.h"
 #include "Price.h"
-#include <unordered_map>
+#include "UserOrders.h"
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <vector>
-#include <map>
-#include <set>
-
-enum struct orderType {
-  GTC,
-  IOC,
-  FOK
-};
 
 class OrderBook {
 private:
-  std::map<Price, std::set<Order>, std::greater<Price>> bids;
-  std::map<Price, std::set<Order>> asks;
+  // Declared first so it outlives the containers whose nodes it owns.
+  std::unique_ptr<AllocationPolicy> allocator;
+
+  BookSide<std::greater<Price>> bids;
+  BookSide<std::less<Price>> asks;
+
+  // Every resting order is reachable from its id, so cancels and fills
+  // unlink it from its level directly instead of searching for it.
+  OrderIndex orders;
+  FlatMap<long long, UserOrders> users;
+
+  Clock* clock = nullptr;
+  // Inside applyBatch() every command is stamped with the batch's time.
+  bool batching = false;
+  long long batchTime = 0;
+  unsigned long long nextSequence = 1;
+  SelfTradePrevention selfTrade = SelfTradePrevention::CancelNewest;
+  DepthFeed* depthFeed = nullptr;
+  TopOfBook top;
+  Seqlock<TopOfBook> topFeed;
+
+  StopBook stops;
+  ExpiryWheel expiries;
+  long long sessionClose = NoExpiry;
+  // Range of prices traded since stops were last checked; empty while
+  // sweepLow > sweepHigh.
+  Price sweepLow{std::numeric_limits<long long>::max()};
+  Price sweepHigh{std::numeric_limits<long long>::min()};
+  Price lastTrade;
+  bool hasTraded = false;
+  bool releasingStops = false;
+  std::vector<StopOrder> triggered;
 
-  std::unordered_map<int, long long> orderIdUserId;
-  std::unordered_map<int, Price> orderIdPrice;
-  std::unordered_map<int, bool> orderIdSide;
+  void publishLevel(bool isBuy, const PriceLevel& level) {
+    if (depthFeed) depthFeed->onLevel(isBuy, level.price, level.totalQuantity, level.orderCount);
+  }
+
+  void noteTrade(Price price) {
+    lastTrade = price;
+    hasTraded = true;
+    if (price < sweepLow) sweepLow = price;
+    if (price > sweepHigh) sweepHigh = price;
+  }
+
+  template <bool IsBuy>
+  auto& sideOf() {
+    if constexpr (IsBuy) return bids;
+    else return asks;
+  }
+
+  template <typename Side>
+  int matchLevels(Side& side, int id, Price price, int quantity, long long userId, long long time, ExecutionSink& sink);
+  template <orderType Type, bool IsBuy>
+  void enterOrder(int id, Price price, int quantity, long long userId, ExecutionSink& sink, int displayQuantity = 0,
+                  long long expireTime = NoExpiry);
+  // Enters a GTC order, iceberg or expiring, and releases any stops it fires.
+  void enterResting(int id, Price price, int quantity, int displayQuantity, bool isBuy, long long userId, long long expireTime,
+                    ExecutionSink& sink);
+  // A GTD without a date comes back already due, so it is rejected.
+  long long expiryOf(orderType type, long long expireTime) const {
+    if (type == orderType::GTD) return expireTime == NoExpiry ? std::numeric_limits<long long>::min() : expireTime;
+    return type == orderType::DAY ? sessionClose : NoExpiry;
+  }
+  void enterTriggered(const StopOrder& stop, ExecutionSink& sink);
+  void releaseStops(ExecutionSink& sink);
+  template <typename Side>
+  char* saveSide(const Side& side, char* out) const;
+  template <typename Side>
+  const char* restoreSide(Side& side, bool isBuy, unsigned long long levels, const char* data, const char* end);
+  template <typename Side>
+  bool canFill(const Side& side, Price price, int quantity, long long userId) const;
+  // Applies the self-trade mode to a conflict with own, updating the incoming
+  // quantity; returns the order to visit next.
+  Order* settleSelfTrade(Order* own, int id, int& quantity, ExecutionSink& sink);
+  // Unlinks a resting order from its level, the index and its owner, and frees it.
+  void retire(Order* order);
+  long long now() const { return batching ? batchTime : clock ? clock->now() : 0; }
+  void refreshTop(bool isBuy, Price changed);
+  // Links a new order into its level, the index and its owner's list;
+  // returns false, leaving the book unchanged, if its id is already in use.
+  template <typename Side>
+  bool restOrder(Side& side, Order* order, Price price);
+  void removeResting(Order* order);
+  void unlinkUser(Order* order);
+  Order* createOrder(int id, int quantity, long long userId, bool isBuy, long long time);
+  void destroyOrder(Order* order);
 
 public:
+  OrderBook();
+  explicit OrderBook(std::unique_ptr<AllocationPolicy> policy);
+  // Ladder mode: prices inside [minPrice, maxPrice] on the tick grid are kept
+  // in dense per-side arrays; anything else falls back to the tree.
+  explicit OrderBook(const LadderConfig& ladder);
+  OrderBook(const LadderConfig& ladder, std::unique_ptr<AllocationPolicy> policy);
+  OrderBook(const OrderBook&) = delete;
+  OrderBook& operator=(const OrderBook&) = delete;
+  ~OrderBook();
+
+  // Dispatches to the addOrder instantiation below for this side and type.
+  void addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, ExecutionSink& sink);
+  // Matching core, compiled once per side and time in force. Callers that
+  // know both statically can call it directly and skip the dispatch.
+  template <orderType Type, bool IsBuy>
+  void addOrder(int id, Price price, int quantity, long long userId, ExecutionSink& sink);
+  // Places a GTC iceberg. It matches on arrival for its full quantity, then
+  // rests showing at most displayQuantity. Each time the visible slice fills,
+  // the next one is drawn from the hidden reserve in place and queued at the
+  // back of its level. depth(), the BBO and the depth feed see only visible
+  // slices; execution reports carry full quantities. A displayQuantity of 0
+  // places a plain GTC order.
+  void addIcebergOrder(int id, Price price, int quantity, int displayQuantity, bool isBuy, long long userId, ExecutionSink& sink);
+  // Places a STOP or STOP_LIMIT order. It waits, out of the book, until a
+  // trade prints at or above stopPrice (buys) or at or below it (sells), or
+  // enters at once if the last trade already has. A fired stop is entered
+  // through addOrder() as an IOC with no price limit, a fired stop-limit as
+  // a GTC at limitPrice; either is reported as accepted again at that point.
+  // Stops fired by the resulting trades are entered in turn. Dormant stops
+  // can be cancelled but not modified. Any other type is a plain addOrder()
+  // at limitPrice. addOrder() with a stop type uses price for both.
+  void addStopOrder(int id, Price stopPrice, Price limitPrice, int quantity, bool isBuy, long long userId, orderType type, ExecutionSink& sink);
+  // Places a GTD or DAY order: a GTC that advanceTime() cancels once the
+  // book's time reaches expireTime (GTD) or the session close (DAY),
+  // reporting it as cancelled. One whose expiry is not after currentTime()
+  // is accepted and cancelled without matching, and so is a GTD with
+  // expireTime NoExpiry or one placed through addOrder() above, which has
+  // no date to give it. An amend that re-queues the order keeps its expiry.
+  // Other types ignore expireTime.
+  void addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, long long expireTime, ExecutionSink& sink);
+  void modifyOrder(int id, Price newPrice, int newQuantity, ExecutionSink& sink);
+  void cancelOrder(int id, ExecutionSink& sink);
+  // Cancels every resting order of userId that filter accepts, reporting
+  // each as cancelled, and returns how many went. The report order is not
+  // specified and may differ after a snapshot restore. It walks the owner's
+  // own order list, so the cost scales with that user's orders, not the
+  // book's; levels it empties are erased on the way and the top of book is
+  // refreshed once at the end. Dormant stops are not resting orders and are
+  // left alone.
+  size_t cancelOrdersForUser(long long userId, const MassCancelFilter& filter, ExecutionSink& sink);
+  size_t cancelAllForUser(long long userId, ExecutionSink& sink) { return cancelOrdersForUser(userId, MassCancelFilter{}, sink); }
+  // Moves the book's time forward to time and cancels every GTD and DAY
+  // order due by then, in amortized O(1) each. Time never moves back.
+  void advanceTime(long long time, ExecutionSink& sink);
+  // Dispatches a queued or journaled command to the matching call above.
+  void apply(const Command& command, ExecutionSink& sink);
+  // Applies count commands in order in one pass. The clock is read once and
+  // that time stamps the whole batch, and index slots are prefetched a few
+  // commands ahead. Pair with ReportSink<AppendReports> to collect every
+  // result in one contiguous buffer.
+  void applyBatch(const Command* commands, size_t count, ExecutionSink& sink);
+
+  // Vector API: trades are appended to the caller's vector, other events are
+  // dropped, including the cancel of an order stopped by self-trade
+  // prevention; check restingOrderCount() or use a sink to see it.
   void addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, std::vector<Trade>& trades);
   void modifyOrder(int id, Price newPrice, int newQuantity, std::vector<Trade>& trades);
-  void printOrderBook() const;
   void cancelOrder(int id);
-};
\ No newline at end of file
+  size_t cancelAllForUser(long long userId);
+  void advanceTime(long long time);
+
+  void printOrderBook() const;
+
+  // Best levels, kept current as the book changes; O(1) for the owning thread.
+  const DepthLevel& bestBid() const { return top.bid; }
+  const DepthLevel& bestAsk() const { return top.ask; }
+  // Best ask minus best bid; 0 while either side is empty.
+  Price spread() const {
+    return top.bid.orderCount && top.ask.orderCount ? Price(top.ask.price.value - top.bid.price.value) : Price();
+  }
+  // Top of book for readers on other threads. Its version() advances only
+  // when the best bid or ask changes, so pollers can skip unchanged reads.
+  const Seqlock<TopOfBook>& topOfBook() const { return topFeed; }
+
+  // Copies up to maxLevels aggregated levels of one side, best first, into
+  // out and returns how many were written.
+  size_t depth(bool isBuy, DepthLevel* out, size_t maxLevels) const;
+  // Every level change from adds, cancels, amends and fills is reported to
+  // feed from now on. The feed is not owned; nullptr detaches it. Snapshot
+  // restores are not reported, so consumers resync from depth() after one.
+  void setDepthFeed(DepthFeed* feed) { depthFeed = feed; }
+
+  // Appends a binary image of every resting order to out (see Snapshot.h).
+  // journalSequence is stored with it so recovery knows where to resume the
+  // journal.
+  void saveSnapshot(std::vector<char>& out, unsigned long long journalSequence = 0) const;
+  // Bulk-loads a snapshot into an empty book: containers are pre-sized and
+  // orders are linked straight into their levels without matching. Returns
+  // the stored journal sequence. Throws std::invalid_argument if the book is
+  // not empty or the image is malformed; a book that threw part-way through
+  // should be discarded.
+  unsigned long long restoreSnapshot(const char* data, size_t size);
+
+  size_t restingOrderCount() const { return orders.size(); }
+  size_t stopOrderCount() const { return stops.size(); }
+  size_t expiringOrderCount() const { return expiries.size(); }
+
+  // Expiry of DAY orders entered from now on; by default they never expire.
+  void setSessionClose(long long time) { sessionClose = time; }
+  long long sessionCloseTime() const { return sessionClose; }
+  // Time of the last advanceTime(), 0 at first.
+  long long currentTime() const { return expiries.time(); }
+
+  // How an order trading against its owner's resting orders is handled;
+  // CancelNewest by default, so an order that reaches one of its owner's
+  // orders loses its remainder. No mode skips past own orders.
+  void setSelfTradePrevention(SelfTradePrevention mode) { selfTrade = mode; }
+  SelfTradePrevention selfTradePrevention() const { return selfTrade; }
+
+  // Timestamps on orders and trades come from clock; without one they are 0.
+  // The clock is not owned and must outlive the book.
+  void setClock(Clock* clock_) { clock = clock_; }
+  // Sequence number the next accepted order will receive.
+  unsigned long long sequence() const { return nextSequence; }
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "FlatMap.h"
+#include "Order.h"
+#include <cstddef>
+
+// Maps an order id straight to its resting node. The node carries side,
+// price and user, so one probe answers everything cancel and modify need.
+class OrderIndex {
+private:
+  FlatMap<int, Order*> map;
+
+public:
+  explicit OrderIndex(size_t capacity = 0) : map(capacity) {}
+
+  size_t size() const { return map.size(); }
+  bool empty() const { return map.empty(); }
+  size_t capacity() const { return map.capacity(); }
+  size_t memoryUsage() const { return map.memoryUsage(); }
+  void reserve(size_t n) { map.reserve(n); }
+
+  static constexpr size_t NoSlot = FlatMap<int, Order*>::NoSlot;
+
+  // Pulls the slot for id into cache and returns it for findAt().
+  size_t prefetch(int id) const { return map.prefetch(id); }
+
+  // The node for id if it sits in slot; see FlatMap::findAt().
+  Order* findAt(size_t slot, int id) const {
+    Order* const* order = map.findAt(slot, id);
+    return order ? *order : nullptr;
+  }
+
+  Order* find(int id) const {
+    Order* const* order = map.find(id);
+    return order ? *order : nullptr;
+  }
+
+  // Returns false (and leaves the index unchanged) if id is already present.
+  bool insert(int id, Order* order) {
+    bool inserted;
+    Order*& slot = map.findOrInsert(id, inserted);
+    if (inserted) slot = order;
+    return inserted;
+  }
+
+  // Removes id and returns its node, or nullptr if it was not present.
+  Order* erase(int id) {
+    Order* removed = nullptr;
+    map.erase(id, &removed);
+    return removed;
+  }
+
+  template <typename F>
+  void forEach(F f) const { map.forEach(f); }
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <limits>
+
+enum struct orderType {
+  GTC,
+  IOC,
+  FOK,
+  // Dormant until a trade prints at or through the stop price, then entered
+  // as a market order (STOP) or a GTC limit order (STOP_LIMIT).
+  STOP,
+  STOP_LIMIT,
+  // GTC orders cancelled once the book's time reaches an expiry: a given
+  // time (GTD) or the session close (DAY).
+  GTD,
+  DAY
+};
+
+inline bool isStop(orderType type) { return type == orderType::STOP || type == orderType::STOP_LIMIT; }
+inline bool expires(orderType type) { return type == orderType::GTD || type == orderType::DAY; }
+
+// Expiry of an order that never expires.
+inline constexpr long long NoExpiry = std::numeric_limits<long long>::max();
+
+// Compile-time behaviour of GTC, IOC and FOK, so the matching core is
+// instantiated once per type with no run-time checks on the order type.
+// GTD and DAY orders match as GTC and carry their expiry separately.
+template <orderType Type>
+struct TimeInForce {
+  // Unfilled quantity rests on the book instead of being cancelled.
+  static constexpr bool Rests = Type == orderType::GTC;
+  // The order executes only if it can fill completely on arrival.
+  static constexpr bool AllOrNone = Type == orderType::FOK;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "PriceLevel.h"
+#include "Price.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// Price band and tick of an instrument whose levels live in a dense array.
+// tickSize is expressed in Price units (cents).
+struct LadderConfig {
+  Price minPrice;
+  Price maxPrice;
+  long long tickSize = 1;
+};
+
+// Contiguous array of price levels indexed by (price - min) / tick, with a
+// bitmap of non-empty levels so that scans skip empty ticks 64 at a time.
+class PriceLadder {
+private:
+  long long minValue = 0;
+  long long tickSize = 1;
+  std::vector<PriceLevel> levels;
+  std::vector<uint64_t> occupied;
+
+public:
+  PriceLadder() = default;
+
+  explicit PriceLadder(const LadderConfig& config)
+    : minValue(config.minPrice.value), tickSize(config.tickSize) {
+    if (config.tickSize <= 0 || config.maxPrice < config.minPrice) {
+      throw std::invalid_argument("PriceLadder: invalid band or tick size");
+    }
+    long long count = (config.maxPrice.value - minValue) / tickSize + 1;
+    levels.reserve(count);
+    for (long long i = 0; i < count; ++i) levels.emplace_back(Price(minValue + i * tickSize));
+    occupied.assign((count + 63) / 64, 0);
+  }
+
+  bool enabled() const { return !levels.empty(); }
+  int size() const { return static_cast<int>(levels.size()); }
+
+  // Index of the level for price, or -1 when the price is outside the band
+  // or not on the tick grid.
+  int indexOf(Price price) const {
+    long long offset = price.value - minValue;
+    if (offset < 0 || offset % tickSize != 0) return -1;
+    long long index = offset / tickSize;
+    return index < static_cast<long long>(levels.size()) ? static_cast<int>(index) : -1;
+  }
+
+  bool owns(const PriceLevel* level) const {
+    return !levels.empty() && level >= levels.data() && level < levels.data() + levels.size();
+  }
+  int indexOf(const PriceLevel* level) const { return static_cast<int>(level - levels.data()); }
+
+  PriceLevel& at(int index) { return levels[index]; }
+  const PriceLevel& at(int index) const { return levels[index]; }
+
+  void setOccupied(int index) { occupied[index >> 6] |= uint64_t(1) << (index & 63); }
+  void clearOccupied(int index) { occupied[index >> 6] &= ~(uint64_t(1) << (index & 63)); }
+
+  // First occupied index >= from, or -1.
+  int nextUp(int from) const {
+    if (from < 0) from = 0;
+    if (from >= size()) return -1;
+    size_t word = from >> 6;
+    uint64_t bits = occupied[word] & (~uint64_t(0) << (from & 63));
+    while (!bits) {
+      if (++word == occupied.size()) return -1;
+      bits = occupied[word];
+    }
+    return static_cast<int>(word * 64 + __builtin_ctzll(bits));
+  }
+
+  // Last occupied index <= from, or -1.
+  int nextDown(int from) const {
+    if (from >= size()) from = size() - 1;
+    if (from < 0) return -1;
+    size_t word = from >> 6;
+    uint64_t bits = occupied[word] & (~uint64_t(0) >> (63 - (from & 63)));
+    while (!bits) {
+      if (word-- == 0) return -1;
+      bits = occupied[word];
+    }
+    return static_cast<int>(word * 64 + 63 - __builtin_clzll(bits));
+  }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Order.h"
+#include "Price.h"
+#include <algorithm>
+
+// FIFO queue of resting orders at a single price. Orders are linked
+// intrusively, so appending, unlinking and partial fills are O(1) and
+// never touch the allocator.
+struct PriceLevel {
+  Price price;
+  Order* head = nullptr;
+  Order* tail = nullptr;
+  long long totalQuantity = 0;
+  // Iceberg reserves behind the visible totalQuantity.
+  long long hiddenQuantity = 0;
+  int orderCount = 0;
+
+  PriceLevel() = default;
+  explicit PriceLevel(Price price_) : price(price_) {}
+
+  bool empty() const { return head == nullptr; }
+
+  void pushBack(Order* order) {
+    order->level = this;
+    order->prev = tail;
+    order->next = nullptr;
+    if (tail) tail->next = order;
+    else head = order;
+    tail = order;
+    totalQuantity += order->quantity;
+    hiddenQuantity += order->hiddenQuantity;
+    ++orderCount;
+  }
+
+  void remove(Order* order) {
+    if (order->prev) order->prev->next = order->next;
+    else head = order->next;
+    if (order->next) order->next->prev = order->prev;
+    else tail = order->prev;
+    totalQuantity -= order->quantity;
+    hiddenQuantity -= order->hiddenQuantity;
+    --orderCount;
+    order->prev = order->next = nullptr;
+    order->level = nullptr;
+  }
+
+  void reduce(Order* order, int quantity) {
+    order->quantity -= quantity;
+    totalQuantity -= quantity;
+  }
+
+  void reduceHidden(Order* order, int quantity) {
+    order->hiddenQuantity -= quantity;
+    hiddenQuantity -= quantity;
+  }
+
+  // Shows the next slice of an iceberg whose visible quantity is used up and
+  // moves it to the back of the queue; the node stays linked everywhere else.
+  // The order must have a positive displayQuantity.
+  void replenish(Order* order) {
+    int slice = std::min(order->details->displayQuantity, order->hiddenQuantity);
+    remove(order);
+    order->hiddenQuantity -= slice;
+    order->quantity += slice;
+    pushBack(order);
+  }
+};
+
+inline Price Order::price() const { return level->price; }
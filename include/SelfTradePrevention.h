@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// What the book does when an incoming order would trade with a resting order
+// of the same user. Each conflict is settled where it is found, so the
+// matcher never walks past the owner's orders.
+enum struct SelfTradePrevention : uint8_t {
+  // The incoming order's remaining quantity is cancelled; the resting order
+  // stays.
+  CancelNewest,
+  // The resting order is cancelled and matching continues behind it.
+  CancelOldest,
+  // Both are cancelled.
+  CancelBoth,
+  // Both lose the smaller of their remaining quantities without trading; an
+  // order left with nothing is removed. The incoming order's loss is
+  // reported as a cancel of that quantity.
+  Decrement
+};
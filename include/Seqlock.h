@@ -0,0 +1,56 @@
+#pragma once
+
+#include "CacheLine.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single-writer sequence lock for a small trivially copyable value. The
+// writer never waits; readers on other threads copy the value and retry if
+// a write overlapped. The payload is held in relaxed atomic words so the
+// overlapping copy is not a data race. version() counts completed writes,
+// which lets a poller detect a change with a single load.
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable_v<T>, "Seqlock holds trivially copyable values");
+
+private:
+  static constexpr size_t Words = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  alignas(CacheLineSize) std::atomic<unsigned long long> sequence{0};
+  std::atomic<uint64_t> words[Words] = {};
+
+public:
+  // Writer side; only one thread may call it.
+  void store(const T& value) {
+    uint64_t raw[Words] = {};
+    std::memcpy(raw, &value, sizeof(T));
+
+    unsigned long long s = sequence.load(std::memory_order_relaxed);
+    sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < Words; ++i) words[i].store(raw[i], std::memory_order_relaxed);
+    sequence.store(s + 2, std::memory_order_release);
+  }
+
+  // Returns a consistent copy; version, if given, receives the matching
+  // version().
+  T load(unsigned long long* version = nullptr) const {
+    uint64_t raw[Words];
+    while (true) {
+      unsigned long long before = sequence.load(std::memory_order_acquire);
+      if (before & 1) continue;
+      for (size_t i = 0; i < Words; ++i) raw[i] = words[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence.load(std::memory_order_relaxed) != before) continue;
+
+      T value;
+      std::memcpy(&value, raw, sizeof(T));
+      if (version) *version = before / 2;
+      return value;
+    }
+  }
+
+  unsigned long long version() const { return sequence.load(std::memory_order_acquire) / 2; }
+};
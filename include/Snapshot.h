@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Price.h"
+#include <cstdint>
+
+// Binary image of a book's resting orders, in native byte order:
+//
+//   SnapshotHeader
+//   bidLevels x (SnapshotLevel, orderCount x SnapshotOrder)   best bid first
+//   askLevels x (SnapshotLevel, orderCount x SnapshotOrder)   best ask first
+//   stopCount x SnapshotStop                                   dormant stops
+//
+// Orders within a level are stored in queue order, so restoring them in
+// file order reproduces time priority. journalSequence is the last journal
+// record reflected in the image; recovery replays the records after it.
+// lastTrade is kept so restored stops fire exactly as they would have, and
+// time and sessionClose so GTD and DAY orders expire as they would have.
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t hasTraded;
+  unsigned long long nextSequence;
+  unsigned long long journalSequence;
+  unsigned long long orderCount;
+  unsigned long long bidLevels;
+  unsigned long long askLevels;
+  unsigned long long stopCount;
+  Price lastTrade;
+  long long time;
+  long long sessionClose;
+};
+
+struct SnapshotLevel {
+  Price price;
+  unsigned long long orderCount;
+};
+
+struct SnapshotOrder {
+  int id;
+  int quantity;
+  int displayQuantity;
+  int hiddenQuantity;
+  long long userId;
+  long long timestamp;
+  unsigned long long sequence;
+  long long expireTime;
+};
+
+struct SnapshotStop {
+  int id;
+  int quantity;
+  Price stopPrice;
+  Price limitPrice;
+  long long userId;
+  unsigned long long sequence;
+  uint32_t type;
+  uint32_t isBuy;
+};
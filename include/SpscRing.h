@@ -0,0 +1,77 @@
+#pragma once
+
+#include "CacheLine.h"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+// Bounded single-producer/single-consumer queue of trivially copyable
+// records. Head and tail sit on their own cache lines, and each side keeps
+// a cached copy of the other's index, so the shared line is only re-read
+// when the ring looks full (producer) or empty (consumer).
+template <typename T>
+class SpscRing {
+  static_assert(std::is_trivially_copyable_v<T>, "SpscRing holds trivially copyable records");
+
+private:
+  alignas(CacheLineSize) std::atomic<size_t> head{0};  // next slot to read
+  size_t cachedTail = 0;
+  alignas(CacheLineSize) std::atomic<size_t> tail{0};  // next slot to write
+  size_t cachedHead = 0;
+  alignas(CacheLineSize) size_t mask;
+  std::unique_ptr<T[]> slots;
+
+public:
+  // capacity must be a power of two.
+  explicit SpscRing(size_t capacity) : mask(capacity - 1), slots(new T[capacity]) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+      throw std::invalid_argument("SpscRing: capacity must be a power of two");
+    }
+  }
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  size_t capacity() const { return mask + 1; }
+
+  // Producer side. Returns false if the ring is full.
+  bool tryPush(const T& value) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cachedHead > mask) {
+      cachedHead = head.load(std::memory_order_acquire);
+      if (t - cachedHead > mask) return false;
+    }
+    slots[t & mask] = value;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if the ring is empty.
+  bool tryPop(T& value) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == cachedTail) {
+      cachedTail = tail.load(std::memory_order_acquire);
+      if (h == cachedTail) return false;
+    }
+    value = slots[h & mask];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Pops up to max records into out; returns how many.
+  size_t popBatch(T* out, size_t max) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (cachedTail - h < max) cachedTail = tail.load(std::memory_order_acquire);
+    size_t n = cachedTail - h;
+    if (n > max) n = max;
+    for (size_t i = 0; i < n; ++i) out[i] = slots[(h + i) & mask];
+    if (n) head.store(h + n, std::memory_order_release);
+    return n;
+  }
+
+  // Approximate when called from neither side.
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+};
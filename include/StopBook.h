@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FlatMap.h"
+#include "OrderType.h"
+#include "Price.h"
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <vector>
+
+// A stop or stop-limit order waiting for its trigger.
+struct StopOrder {
+  int id = 0;
+  int quantity = 0;
+  Price stopPrice;
+  Price limitPrice;
+  long long userId = 0;
+  unsigned long long sequence = 0;
+  orderType type = orderType::STOP;
+  bool isBuy = false;
+};
+
+// Trigger index for dormant stops. A buy stop fires on a trade at or above
+// its stop price and a sell stop on a trade at or below it, so buys are kept
+// in ascending and sells in descending stop price: the stops a range of
+// trade prices fires are always a prefix of each side, and a range that
+// fires none costs one comparison per side however many stops are waiting.
+class StopBook {
+private:
+  template <typename Compare>
+  using Side = std::multimap<Price, StopOrder, Compare>;
+
+  // Equal stop prices keep arrival order: multimap inserts after equal keys.
+  Side<std::less<Price>> buys;
+  Side<std::greater<Price>> sells;
+  FlatMap<int, StopOrder> index;  // id -> copy holding the side and key
+
+  template <typename S>
+  static bool erase(S& side, const StopOrder& stop) {
+    auto range = side.equal_range(stop.stopPrice);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.id == stop.id) {
+        side.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  template <typename S, typename Fires>
+  void takeFrom(S& side, Fires fires, std::vector<StopOrder>& out) {
+    auto it = side.begin();
+    for (; it != side.end() && fires(it->first); ++it) {
+      out.push_back(it->second);
+      index.erase(it->second.id);
+    }
+    side.erase(side.begin(), it);
+  }
+
+public:
+  size_t size() const { return index.size(); }
+  bool empty() const { return index.empty(); }
+  bool contains(int id) const { return index.find(id) != nullptr; }
+
+  // Returns false if a stop with this id is already waiting.
+  bool add(const StopOrder& stop) {
+    bool inserted = false;
+    StopOrder& slot = index.findOrInsert(stop.id, inserted);
+    if (!inserted) return false;
+    slot = stop;
+    if (stop.isBuy) buys.emplace(stop.stopPrice, stop);
+    else sells.emplace(stop.stopPrice, stop);
+    return true;
+  }
+
+  bool remove(int id, StopOrder* removed = nullptr) {
+    StopOrder stop;
+    if (!index.erase(id, &stop)) return false;
+    if (stop.isBuy) erase(buys, stop);
+    else erase(sells, stop);
+    if (removed) *removed = stop;
+    return true;
+  }
+
+  // True if a trade somewhere in [low, high] fires at least one stop.
+  bool triggeredBy(Price low, Price high) const {
+    return (!buys.empty() && buys.begin()->first <= high) || (!sells.empty() && sells.begin()->first >= low);
+  }
+
+  // Moves every stop fired by trades in [low, high] into out, replacing its
+  // contents, in arrival order.
+  void take(Price low, Price high, std::vector<StopOrder>& out) {
+    out.clear();
+    takeFrom(buys, [high](Price stop) { return stop <= high; }, out);
+    takeFrom(sells, [low](Price stop) { return stop >= low; }, out);
+    std::sort(out.begin(), out.end(), [](const StopOrder& a, const StopOrder& b) { return a.sequence < b.sequence; });
+  }
+
+  // Visits buys in ascending, then sells in descending stop price.
+  template <typename F>
+  void forEach(F f) const {
+    for (const auto& entry : buys) f(entry.second);
+    for (const auto& entry : sells) f(entry.second);
+  }
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "ExecutionSink.h"
+#include "Trade.h"
+#include <ostream>
+
+// Streams each trade to a text log as it happens instead of buffering them.
+class TradeLogSink : public ExecutionSink {
+private:
+  std::ostream& out;
+
+public:
+  explicit TradeLogSink(std::ostream& out_) : out(out_) {}
+
+  void onTrade(const Trade& trade) override {
+    out << "passive: " << trade.passiveId << " agressive: " << trade.agressiveId << " price: " << trade.price
+        << " quantity: " << trade.quantity << " time: " << trade.timestamp << "\n";
+  }
+};
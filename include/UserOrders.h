@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Order.h"
+#include "PriceLevel.h"
+#include <limits>
+
+// Resting orders of one user, linked intrusively through their
+// OrderDetails in the order they came to rest. The list stays in cold
+// memory, so maintaining it never touches a neighbour's order record.
+struct UserOrders {
+  OrderDetails* head = nullptr;
+  OrderDetails* tail = nullptr;
+  int orderCount = 0;
+  int buyCount = 0;
+
+  bool empty() const { return head == nullptr; }
+  int countOn(bool isBuy) const { return isBuy ? buyCount : orderCount - buyCount; }
+
+  // The user's most aggressive resting price on one side; that side must
+  // not be empty. Kept on insert, and rescanned only after the order at
+  // that price leaves.
+  Price bestOn(bool isBuy) const {
+    if (bestStale[isBuy]) {
+      bool found = false;
+      for (const OrderDetails* details = head; details; details = details->userNext) {
+        const Order* order = details->order;
+        if (order->isBuy != isBuy) continue;
+        Price price = order->price();
+        if (!found || better(isBuy, price, best[isBuy])) best[isBuy] = price;
+        found = true;
+      }
+      bestStale[isBuy] = false;
+    }
+    return best[isBuy];
+  }
+
+  // The order must still be on its price level.
+  void pushBack(Order* order) {
+    OrderDetails* details = order->details;
+    details->userPrev = tail;
+    details->userNext = nullptr;
+    if (tail) tail->userNext = details;
+    else head = details;
+    tail = details;
+    ++orderCount;
+    buyCount += order->isBuy;
+    Price price = order->price();
+    if (countOn(order->isBuy) == 1 || (!bestStale[order->isBuy] && better(order->isBuy, price, best[order->isBuy]))) {
+      best[order->isBuy] = price;
+      bestStale[order->isBuy] = false;
+    }
+  }
+
+  // The order must still be on its price level.
+  void remove(Order* order) {
+    OrderDetails* details = order->details;
+    if (details->userPrev) details->userPrev->userNext = details->userNext;
+    else head = details->userNext;
+    if (details->userNext) details->userNext->userPrev = details->userPrev;
+    else tail = details->userPrev;
+    details->userPrev = details->userNext = nullptr;
+    --orderCount;
+    buyCount -= order->isBuy;
+    if (order->price() == best[order->isBuy]) bestStale[order->isBuy] = true;
+  }
+
+private:
+  // Indexed by isBuy.
+  mutable Price best[2];
+  mutable bool bestStale[2] = {false, false};
+
+  static bool better(bool isBuy, Price a, Price b) { return isBuy ? a > b : a < b; }
+};
+
+// Which of a user's resting orders a mass cancel takes: one or both sides,
+// and prices within [minPrice, maxPrice]. The default takes everything.
+struct MassCancelFilter {
+  bool buys = true;
+  bool sells = true;
+  Price minPrice{std::numeric_limits<long long>::min()};
+  Price maxPrice{std::numeric_limits<long long>::max()};
+
+  static MassCancelFilter side(bool isBuy) {
+    MassCancelFilter filter;
+    filter.buys = isBuy;
+    filter.sells = !isBuy;
+    return filter;
+  }
+
+  static MassCancelFilter priceRange(Price low, Price high) {
+    MassCancelFilter filter;
+    filter.minPrice = low;
+    filter.maxPrice = high;
+    return filter;
+  }
+
+  bool wantsSide(bool isBuy) const { return isBuy ? buys : sells; }
+  bool matches(bool isBuy, Price price) const { return wantsSide(isBuy) && price >= minPrice && price <= maxPrice; }
+};
@@ -32,6 +32,31 @@ def extract_throughput_benchmarks(data: Dict[str, Any]) -> List[Dict[str, Any]]:
             throughput_benchmarks.append(benchmark)
     return throughput_benchmarks
 
+def range_value(name: str):
+    # First numeric argument of a benchmark name, e.g. 1000 in
+    # "BM_X/1000" or "BM_X/orders:1000/real_time"; None if there is none.
+    for part in name.split('/')[1:]:
+        value = part.split(':')[-1]
+        if value.isdigit():
+            return int(value)
+    return None
+
+PERCENTILE_COUNTERS = [('p50', 'p50_ns'), ('p99', 'p99_ns'), ('p99.9', 'p999_ns')]
+
+def counter_percentile_groups(benchmarks: List[Dict[str, Any]]) -> Dict[str, Dict[str, float]]:
+    # Percentiles reported as counters by histogram-based benchmarks: p50_ns,
+    # p99_ns and p999_ns for the whole run, optionally prefixed per operation
+    # (add_p99_ns, cancel_p99_ns, ...).
+    groups = {}
+    for bench in benchmarks:
+        base = '/'.join(part for part in bench.get('name', '').replace('BM_', '').split('/')
+                        if part != 'real_time' and not part.startswith('iterations:'))
+        prefixes = {key[:-len('p50_ns')] for key in bench if key.endswith('p50_ns')}
+        for prefix in sorted(prefixes):
+            label = f"{base} {prefix.rstrip('_')}".strip()
+            groups[label] = {pct: bench.get(prefix + key, 0) for pct, key in PERCENTILE_COUNTERS}
+    return groups
+
 def calculate_percentiles(times: List[float]) -> Dict[str, float]:
     if not times:
         return {'p50': 0, 'p99': 0, 'p99.9': 0}
@@ -134,7 +159,7 @@ def plot_throughput_comparison(throughput_benchmarks: List[Dict[str, Any]], outp
     for bench in throughput_benchmarks:
         name = bench.get('name', '')
         base_name = name.split('/')[0].replace('BM_', '').replace('_', ' ')
-        range_param = name.split('/')[-1] if '/' in name else ''
+        range_param = range_value(name)
         throughput = bench.get('items_per_second', 0)
         
         benchmark_data.append({
@@ -161,10 +186,10 @@ def plot_throughput_comparison(throughput_benchmarks: List[Dict[str, Any]], outp
     for idx, (name, items) in enumerate(sorted(grouped_data.items())[:3]):
         ax = axes[idx] if n_groups > 1 else axes[0]
         
-        items_sorted = sorted(items, key=lambda x: int(x['range']) if x['range'].isdigit() else 0)
+        items_sorted = sorted(items, key=lambda x: x['range'] or 0)
         
         if len(items_sorted) > 1:
-            ranges = [int(item['range']) if item['range'].isdigit() else 0 for item in items_sorted]
+            ranges = [item['range'] or 0 for item in items_sorted]
             throughputs = [item['throughput'] for item in items_sorted]
             
             ax.plot(ranges, throughputs, marker='o', linewidth=2, markersize=8)
@@ -204,8 +229,10 @@ def plot_scaling_analysis(latency_benchmarks: List[Dict[str, Any]], output_dir:
     for bench in scaling_benchmarks:
         name = bench.get('name', '')
         base_name = name.split('/')[0]
-        range_param = int(name.split('/')[-1])
+        range_param = range_value(name)
         time_ns = bench.get('real_time', 0)
+        if range_param is None:
+            continue
         
         if base_name not in grouped:
             grouped[base_name] = []
@@ -238,6 +265,34 @@ def plot_scaling_analysis(latency_benchmarks: List[Dict[str, Any]], output_dir:
     print(f"Saved scaling analysis to {output_file}")
     plt.close()
 
+def plot_counter_percentiles(throughput_benchmarks: List[Dict[str, Any]], output_dir: Path):
+    groups = counter_percentile_groups(throughput_benchmarks)
+    if not groups:
+        return
+    
+    labels = list(groups.keys())
+    x = np.arange(len(labels))
+    width = 0.25
+    
+    fig, ax = plt.subplots(figsize=(max(10, len(labels) * 0.9), 7))
+    colors = {'p50': 'green', 'p99': 'orange', 'p99.9': 'red'}
+    for offset, (pct, _) in zip((-width, 0, width), PERCENTILE_COUNTERS):
+        ax.bar(x + offset, [groups[label][pct] for label in labels], width, label=pct, color=colors[pct], alpha=0.8)
+    
+    ax.set_ylabel('Latency (nanoseconds)', fontsize=12)
+    ax.set_title('Per-Operation Latency Percentiles', fontsize=14, fontweight='bold')
+    ax.set_xticks(x)
+    ax.set_xticklabels(labels, rotation=45, ha='right')
+    ax.set_yscale('log')
+    ax.legend()
+    ax.grid(axis='y', alpha=0.3)
+    
+    plt.tight_layout()
+    output_file = output_dir / 'latency_percentiles.png'
+    plt.savefig(output_file, dpi=300, bbox_inches='tight')
+    print(f"Saved latency percentiles to {output_file}")
+    plt.close()
+
 def generate_summary_report(data: Dict[str, Any], output_dir: Path):
     output_file = output_dir / 'benchmark_summary.txt'
     
@@ -283,6 +338,8 @@ def generate_summary_report(data: Dict[str, Any], output_dir: Path):
                 f.write(f"\n{name}:\n")
                 f.write(f"  Throughput: {throughput:,.0f} orders/second\n")
                 f.write(f"  Throughput: {throughput/1_000_000:.2f} million orders/second\n")
+                for label, values in counter_percentile_groups([bench]).items():
+                    f.write(f"  {label}: " + ", ".join(f"{pct} {value:,.0f} ns" for pct, value in values.items()) + "\n")
         
         f.write("\n" + "=" * 80 + "\n")
     
@@ -324,6 +381,7 @@ def main():
     print("\nGenerating visualizations...")
     plot_latency_comparison(latency_benchmarks, args.output_dir)
     plot_throughput_comparison(throughput_benchmarks, args.output_dir)
+    plot_counter_percentiles(throughput_benchmarks, args.output_dir)
     plot_scaling_analysis(latency_benchmarks, args.output_dir)
     generate_summary_report(data, args.output_dir)
     
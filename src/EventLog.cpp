@@ -0,0 +1,150 @@
+#include "EventLog.h"
+#include "MatchingThread.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char EventLogMagic[8] = {'O', 'B', 'E', 'V', 'L', 'O', 'G', '1'};
+static const uint32_t EventLogVersion = 1;
+static const size_t BufferAlignment = 4096;
+
+EventLogWriter::EventLogWriter(const std::string& path) : EventLogWriter(path, Config{}) {}
+
+EventLogWriter::EventLogWriter(const std::string& path, const Config& config_)
+  : config(config_), ring(config_.ringCapacity) {
+  bufferRecords = std::max<size_t>(1, config.bufferBytes / sizeof(ExecutionReport));
+  size_t bytes = (bufferRecords * sizeof(ExecutionReport) + BufferAlignment - 1) / BufferAlignment * BufferAlignment;
+  buffer = static_cast<ExecutionReport*>(std::aligned_alloc(BufferAlignment, bytes));
+  if (!buffer) throw std::runtime_error("cannot allocate event log buffer");
+
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::free(buffer);
+    throw std::runtime_error("cannot create event log " + path);
+  }
+  EventLogHeader header;
+  std::memcpy(header.magic, EventLogMagic, sizeof(header.magic));
+  header.version = EventLogVersion;
+  header.recordSize = sizeof(ExecutionReport);
+  if (!writeAll(&header, sizeof(header))) {
+    ::close(fd);
+    std::free(buffer);
+    throw std::runtime_error("cannot write event log " + path);
+  }
+
+  running.store(true, std::memory_order_release);
+  writer = std::thread([this] { run(); });
+}
+
+EventLogWriter::~EventLogWriter() {
+  close();
+  std::free(buffer);
+}
+
+void EventLogWriter::close() {
+  if (fd < 0) return;
+  running.store(false, std::memory_order_release);
+  if (writer.joinable()) writer.join();
+  ::close(fd);
+  fd = -1;
+}
+
+void EventLogWriter::logSlow(const ExecutionReport& report) {
+  unsigned spins = 0;
+  ++stallCount;
+  while (!ring.tryPush(report)) idleSpin(spins);
+}
+
+bool EventLogWriter::writeAll(const void* data, size_t bytes) {
+  const char* cursor = static_cast<const char*>(data);
+  while (bytes) {
+    ssize_t n = ::write(fd, cursor, bytes);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    cursor += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void EventLogWriter::run() {
+  pinCurrentThread(config.core);
+  using Clock = std::chrono::steady_clock;
+  const auto flushInterval = std::chrono::microseconds(config.flushIntervalMicros);
+  auto lastWrite = Clock::now();
+  size_t used = 0;
+  unsigned spins = 0;
+
+  auto flush = [&] {
+    if (!writeFailed.load(std::memory_order_relaxed) && !writeAll(buffer, used * sizeof(ExecutionReport))) {
+      writeFailed.store(true, std::memory_order_release);
+    }
+    if (!writeFailed.load(std::memory_order_relaxed)) writtenCount.fetch_add(used, std::memory_order_release);
+    used = 0;
+    lastWrite = Clock::now();
+  };
+
+  for (;;) {
+    // Read the flag first so nothing logged before close() is left behind.
+    bool stopping = !running.load(std::memory_order_acquire);
+    size_t n = ring.popBatch(buffer + used, bufferRecords - used);
+    used += n;
+    if (used == bufferRecords) {
+      flush();
+      continue;
+    }
+    if (n) {
+      spins = 0;
+      continue;
+    }
+    if (stopping) break;
+    if (used && Clock::now() - lastWrite >= flushInterval) flush();
+    else idleSpin(spins);
+  }
+  if (used) flush();
+}
+
+EventLogReader::EventLogReader(const std::string& path) {
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("cannot open event log " + path);
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(EventLogHeader)) {
+    ::close(fd);
+    throw std::runtime_error("not an event log: " + path);
+  }
+  mappedBytes = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd);
+    throw std::runtime_error("cannot map event log " + path);
+  }
+  base = static_cast<char*>(mapped);
+  madvise(base, mappedBytes, MADV_SEQUENTIAL);
+
+  EventLogHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, EventLogMagic, sizeof(header.magic)) != 0 || header.version != EventLogVersion ||
+      header.recordSize != sizeof(ExecutionReport)) {
+    munmap(base, mappedBytes);
+    ::close(fd);
+    throw std::runtime_error("not an event log: " + path);
+  }
+
+  first = reinterpret_cast<const ExecutionReport*>(base + sizeof(header));
+  count = (mappedBytes - sizeof(header)) / sizeof(ExecutionReport);
+}
+
+EventLogReader::~EventLogReader() {
+  munmap(base, mappedBytes);
+  ::close(fd);
+}
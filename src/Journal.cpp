@@ -0,0 +1,149 @@
+#include "Journal.h"
+#include "Clock.h"
+#include "OrderBook.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char JournalMagic[8] = {'O', 'B', 'J', 'R', 'N', 'L', '1', '\0'};
+static const uint32_t JournalVersion = 4;
+
+// Word-at-a-time multiplicative hash over everything before the checksum.
+static unsigned long long recordChecksum(const JournalRecord& record) {
+  const size_t words = offsetof(JournalRecord, checksum) / sizeof(uint64_t);
+  const char* bytes = reinterpret_cast<const char*>(&record);
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < words; ++i) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+    hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+static size_t pageSize() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+JournalWriter::JournalWriter(const std::string& path) : JournalWriter(path, Config{}) {}
+
+JournalWriter::JournalWriter(const std::string& path, const Config& config_) : config(config_) {
+  fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) throw std::runtime_error("cannot create journal " + path);
+  grow();
+
+  JournalHeader header;
+  std::memcpy(header.magic, JournalMagic, sizeof(header.magic));
+  header.version = JournalVersion;
+  header.recordSize = sizeof(JournalRecord);
+  std::memcpy(base, &header, sizeof(header));
+  writtenBytes = sizeof(header);
+  commit();
+}
+
+JournalWriter::~JournalWriter() {
+  if (fd < 0) return;
+  if (base) {
+    commit();
+    munmap(base, mappedBytes);
+  }
+  if (ftruncate(fd, static_cast<off_t>(writtenBytes)) == 0 && config.sync) fsync(fd);
+  ::close(fd);
+}
+
+void JournalWriter::grow() {
+  size_t newSize = mappedBytes + config.growBytes;
+  if (ftruncate(fd, static_cast<off_t>(newSize)) != 0) throw std::runtime_error("cannot extend journal");
+  if (base) munmap(base, mappedBytes);
+  void* mapped = mmap(nullptr, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    base = nullptr;
+    throw std::runtime_error("cannot map journal");
+  }
+  base = static_cast<char*>(mapped);
+  mappedBytes = newSize;
+  // The new file length has to be durable before records beyond it are.
+  if (config.sync) fdatasync(fd);
+}
+
+unsigned long long JournalWriter::append(const Command& command) {
+  if (writtenBytes + sizeof(JournalRecord) > mappedBytes) grow();
+
+  JournalRecord record;
+  record.sequence = nextSequence;
+  record.command = command;
+  record.checksum = recordChecksum(record);
+  std::memcpy(base + writtenBytes, &record, sizeof(record));
+  writtenBytes += sizeof(record);
+
+  if (config.groupCommit && nextSequence % config.groupCommit == 0) commit();
+  return nextSequence++;
+}
+
+void JournalWriter::commit() {
+  if (writtenBytes == committedBytes) return;
+  if (config.sync) {
+    size_t start = committedBytes & ~(pageSize() - 1);
+    msync(base + start, writtenBytes - start, MS_SYNC);
+  }
+  committedBytes = writtenBytes;
+}
+
+JournalReader::JournalReader(const std::string& path) {
+  fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("cannot open journal " + path);
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(JournalHeader)) {
+    ::close(fd);
+    throw std::runtime_error("not a journal: " + path);
+  }
+  mappedBytes = static_cast<size_t>(info.st_size);
+  void* mapped = mmap(nullptr, mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    ::close(fd);
+    throw std::runtime_error("cannot map journal " + path);
+  }
+  base = static_cast<char*>(mapped);
+  madvise(base, mappedBytes, MADV_SEQUENTIAL);
+
+  JournalHeader header;
+  std::memcpy(&header, base, sizeof(header));
+  if (std::memcmp(header.magic, JournalMagic, sizeof(header.magic)) != 0 || header.version != JournalVersion ||
+      header.recordSize != sizeof(JournalRecord)) {
+    munmap(base, mappedBytes);
+    ::close(fd);
+    throw std::runtime_error("not a journal: " + path);
+  }
+
+  first = reinterpret_cast<const JournalRecord*>(base + sizeof(header));
+  size_t available = (mappedBytes - sizeof(header)) / sizeof(JournalRecord);
+  while (count < available && first[count].sequence == count + 1 && first[count].checksum == recordChecksum(first[count])) {
+    ++count;
+  }
+}
+
+JournalReader::~JournalReader() {
+  munmap(base, mappedBytes);
+  ::close(fd);
+}
+
+size_t replayJournal(const JournalReader& journal, OrderBook& book, ExecutionSink& sink, unsigned long long afterSequence) {
+  // Record i carries sequence i + 1.
+  const JournalRecord* first = journal.begin() + std::min<unsigned long long>(afterSequence, journal.size());
+  ManualClock clock;
+  book.setClock(&clock);
+  for (const JournalRecord* record = first; record != journal.end(); ++record) {
+    clock.set(record->command.timestamp);
+    book.apply(record->command, sink);
+  }
+  book.setClock(nullptr);
+  return journal.end() - first;
+}
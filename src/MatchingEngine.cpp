@@ -0,0 +1,108 @@
+#include "MatchingEngine.h"
+
+OrderDirectory::OrderDirectory(size_t capacity)
+  : dense(new std::atomic<uint32_t>[capacity]), denseSize(capacity) {
+  for (size_t i = 0; i < capacity; ++i) dense[i].store(0, std::memory_order_relaxed);
+}
+
+void OrderDirectory::insert(int id, uint32_t instrument) {
+  if (isDense(id)) {
+    dense[id].store(instrument + 1, std::memory_order_release);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(overflowMutex);
+  overflow[id] = instrument;
+}
+
+bool OrderDirectory::find(int id, uint32_t& instrument) const {
+  if (isDense(id)) {
+    uint32_t entry = dense[id].load(std::memory_order_acquire);
+    if (!entry) return false;
+    instrument = entry - 1;
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(overflowMutex);
+  const uint32_t* found = overflow.find(id);
+  if (!found) return false;
+  instrument = *found;
+  return true;
+}
+
+void OrderDirectory::erase(int id) {
+  if (isDense(id)) {
+    dense[id].store(0, std::memory_order_release);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(overflowMutex);
+  overflow.erase(id);
+}
+
+MatchingEngine::MatchingEngine(const Config& config_)
+  : config(config_), directory(config_.directoryCapacity) {
+  for (int i = 0; i < config.shards; ++i) {
+    MatchingThread::Config worker;
+    worker.producers = config.producers;
+    worker.inboundCapacity = config.inboundCapacity;
+    worker.outboundCapacity = config.outboundCapacity;
+    worker.core = config.firstCore < 0 ? -1 : config.firstCore + i;
+    workers.push_back(std::make_unique<MatchingThread>(worker, nullptr));
+  }
+}
+
+int MatchingEngine::shardOf(uint32_t instrument) const {
+  uint64_t hash = (static_cast<uint64_t>(instrument) * 11400714819323198485ull) >> 32;
+  return static_cast<int>(hash % workers.size());
+}
+
+bool MatchingEngine::addInstrument(uint32_t instrument, std::unique_ptr<OrderBook> book) {
+  return workers[shardOf(instrument)]->addBook(instrument, std::move(book));
+}
+
+void MatchingEngine::start() {
+  for (auto& worker : workers) worker->start();
+}
+
+void MatchingEngine::stop() {
+  for (auto& worker : workers) worker->stop();
+}
+
+bool MatchingEngine::submit(int producer, Command command) {
+  if (command.type == CommandType::Add) {
+    if (!workers[shardOf(command.instrument)]->submit(producer, command)) return false;
+    // Only orders that can rest or wait for a trigger are ever cancelled or
+    // amended later.
+    if (command.tif == orderType::GTC || isStop(command.tif) || expires(command.tif)) directory.insert(command.id, command.instrument);
+    return true;
+  }
+  if (command.type == CommandType::AdvanceTime) return workers[shardOf(command.instrument)]->submit(producer, command);
+
+  if (!directory.find(command.id, command.instrument)) return false;
+  if (!workers[shardOf(command.instrument)]->submit(producer, command)) return false;
+  if (command.type == CommandType::Cancel || command.quantity <= 0) directory.erase(command.id);
+  return true;
+}
+
+bool MatchingEngine::poll(ExecutionReport& report) {
+  for (size_t i = 0; i < workers.size(); ++i) {
+    MatchingThread& worker = *workers[nextPoll];
+    nextPoll = nextPoll + 1 == workers.size() ? 0 : nextPoll + 1;
+    if (worker.poll(report)) return true;
+  }
+  return false;
+}
+
+size_t MatchingEngine::pollBatch(ExecutionReport* out, size_t max) {
+  size_t total = 0;
+  for (size_t i = 0; i < workers.size() && total < max; ++i) {
+    MatchingThread& worker = *workers[nextPoll];
+    nextPoll = nextPoll + 1 == workers.size() ? 0 : nextPoll + 1;
+    total += worker.pollBatch(out + total, max - total);
+  }
+  return total;
+}
+
+unsigned long long MatchingEngine::processed() const {
+  unsigned long long total = 0;
+  for (const auto& worker : workers) total += worker->processed();
+  return total;
+}
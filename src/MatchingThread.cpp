@@ -0,0 +1,134 @@
+#include "MatchingThread.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+void pinCurrentThread(int core) {
+#if defined(__linux__)
+  if (core < 0) return;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+  (void)core;
+#endif
+}
+
+void idleSpin(unsigned& spins) {
+  if (++spins < 256) {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+    return;
+  }
+  spins = 0;
+  std::this_thread::yield();
+}
+
+MatchingThread::MatchingThread(const Config& config_, std::unique_ptr<OrderBook> book)
+  : config(config_), outbound(config_.outboundCapacity) {
+  for (int i = 0; i < config.producers; ++i) {
+    inbound.push_back(std::make_unique<SpscRing<Command>>(config.inboundCapacity));
+  }
+  if (book) addBook(0, std::move(book));
+}
+
+bool MatchingThread::addBook(uint32_t instrument, std::unique_ptr<OrderBook> book) {
+  bool inserted = false;
+  OrderBook*& slot = books.findOrInsert(instrument, inserted);
+  if (!inserted) return false;
+  book->setClock(&clock);
+  slot = book.get();
+  ownedBooks.push_back(std::move(book));
+  return true;
+}
+
+MatchingThread::~MatchingThread() { stop(); }
+
+void MatchingThread::start() {
+  if (running.exchange(true)) return;
+  thread = std::thread(&MatchingThread::run, this);
+}
+
+void MatchingThread::stop() {
+  running.store(false, std::memory_order_release);
+  if (thread.joinable()) thread.join();
+}
+
+bool MatchingThread::snapshot(uint32_t instrument, std::vector<char>& out) {
+  OrderBook* target = book(instrument);
+  if (!target) return false;
+  if (!thread.joinable()) {
+    target->saveSnapshot(out, journal ? journal->records() : 0);
+    return true;
+  }
+
+  SnapshotRequest request{instrument, &out};
+  pendingSnapshot.store(&request, std::memory_order_release);
+  unsigned spins = 0;
+  while (!request.done.load(std::memory_order_acquire)) idleSpin(spins);
+  return true;
+}
+
+void MatchingThread::serveSnapshot() {
+  SnapshotRequest* request = pendingSnapshot.load(std::memory_order_acquire);
+  if (!request) return;
+  // Everything journaled so far has been applied, so the image lines up
+  // exactly with the journal's current length.
+  book(request->instrument)->saveSnapshot(*request->out, journal ? journal->records() : 0);
+  pendingSnapshot.store(nullptr, std::memory_order_relaxed);
+  request->done.store(true, std::memory_order_release);
+}
+
+void MatchingThread::publish(const ExecutionReport& report) {
+  unsigned spins = 0;
+  while (!outbound.tryPush(report)) idleSpin(spins);
+}
+
+void MatchingThread::run() {
+  pinCurrentThread(config.core);
+
+  auto publisher = [this](const ExecutionReport& report) { publish(report); };
+  ReportSink<decltype(publisher)> sink(publisher);
+  Command batch[64];
+  unsigned spins = 0;
+
+  while (true) {
+    serveSnapshot();
+    size_t handled = 0;
+    for (auto& ring : inbound) {
+      size_t n = ring->popBatch(batch, 64);
+      if (journal && n) {
+        for (size_t i = 0; i < n; ++i) journal->append(batch[i]);
+        journal->commit();
+      }
+      for (size_t i = 0; i < n; ++i) {
+        OrderBook** book = books.find(batch[i].instrument);
+        if (!book) continue;
+        clock.set(batch[i].timestamp);
+        sink.timestamp = batch[i].timestamp;
+        sink.instrument = batch[i].instrument;
+        (*book)->apply(batch[i], sink);
+      }
+      handled += n;
+    }
+
+    if (handled) {
+      processedCount.fetch_add(handled, std::memory_order_release);
+      spins = 0;
+    } else if (!running.load(std::memory_order_acquire)) {
+      // Commands pushed before stop() are visible by now; drain them first.
+      bool drained = true;
+      for (auto& ring : inbound) drained = drained && ring->empty();
+      if (drained) break;
+    } else {
+      idleSpin(spins);
+    }
+  }
+}
@@ -1,176 +1,575 @@
 #include "OrderBook.h"
 #include <iostream>
-#include <chrono>
 
-void OrderBook::addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, std::vector<Trade>& trades) {
-  auto now = std::chrono::system_clock::now();
-  long long time = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+OrderBook::OrderBook() : OrderBook(std::make_unique<PoolAllocationPolicy>()) {}
 
-  if(type == orderType::FOK) {
-    int availableQty = 0;
-    bool canFill = false;
+OrderBook::OrderBook(std::unique_ptr<AllocationPolicy> policy)
+  : allocator(std::move(policy)), bids(allocator.get()), asks(allocator.get()) {}
 
-    if (isBuy) {
-      auto it = asks.begin();
+OrderBook::OrderBook(const LadderConfig& ladder) : OrderBook(ladder, std::make_unique<PoolAllocationPolicy>()) {}
 
-      while (it != asks.end() && it->first <= price) {
-        for (const auto& order : it->second) {
-          if (order.userId == userId) continue;
+OrderBook::OrderBook(const LadderConfig& ladder, std::unique_ptr<AllocationPolicy> policy)
+  : allocator(std::move(policy)), bids(ladder, allocator.get()), asks(ladder, allocator.get()) {}
 
-          availableQty += order.quantity;
-          if (availableQty >= quantity) {
-            canFill = true;
-            break;
-          }
-        }
-        if (canFill) break;
-        ++it;
+OrderBook::~OrderBook() {
+  orders.forEach([this](int, Order* order) { destroyOrder(order); });
+}
+
+Order* OrderBook::createOrder(int id, int quantity, long long userId, bool isBuy, long long time) {
+  OrderDetails* details = new (allocator->allocateDetails()) OrderDetails;
+  details->timestamp = time;
+  details->order = new (allocator->allocateOrder()) Order(id, quantity, userId, isBuy, details);
+  return details->order;
+}
+
+void OrderBook::destroyOrder(Order* order) {
+  OrderDetails* details = order->details;
+  expiries.cancel(details);
+  order->~Order();
+  allocator->deallocateOrder(order);
+  details->~OrderDetails();
+  allocator->deallocateDetails(details);
+}
+
+template <typename Side>
+bool OrderBook::canFill(const Side& side, Price price, int quantity, long long userId) const {
+  // Levels better than the owner's best price on this side hold none of
+  // its orders and are summed from their aggregates.
+  const UserOrders* own = users.find(userId);
+  bool ownInReach = own && own->countOn(Side::IsBidSide) > 0;
+  Price ownBest = ownInReach ? own->bestOn(Side::IsBidSide) : Price();
+  ownInReach = ownInReach && side.crosses(price, ownBest);
+  long long availableQty = 0;
+
+  for (auto cursor = side.begin(); cursor.level && side.crosses(price, cursor.level->price); side.advance(cursor)) {
+    const PriceLevel& level = *cursor.level;
+    if (!ownInReach || !side.crosses(level.price, ownBest)) {
+      availableQty += level.totalQuantity + level.hiddenQuantity;
+      if (availableQty >= quantity) return true;
+      continue;
+    }
+
+    // The owner may be queued here, so walk the level to find where its
+    // first order falls. Only CancelOldest lets matching go past it.
+    long long hidden = level.hiddenQuantity;
+    for (const Order* order = level.head; order; order = order->next) {
+      if (order->userId == userId) {
+        if (selfTrade != SelfTradePrevention::CancelOldest) return false;
+        hidden -= order->hiddenQuantity;
+        continue;
       }
-    } else {
-      auto it = bids.begin();
+      availableQty += order->quantity;
+      if (availableQty >= quantity) return true;
+    }
+    availableQty += hidden;
+    if (availableQty >= quantity) return true;
+  }
+  return false;
+}
+
+void OrderBook::retire(Order* order) {
+  unlinkUser(order);
+  order->level->remove(order);
+  orders.erase(order->id);
+  destroyOrder(order);
+}
+
+Order* OrderBook::settleSelfTrade(Order* own, int id, int& quantity, ExecutionSink& sink) {
+  Order* next = own->next;
+  int ownRemaining = own->quantity + own->hiddenQuantity;
 
-      while (it != bids.end() && it->first >= price) {
-        for (const auto& order : it->second) {
-          if (order.userId == userId) continue;
+  switch (selfTrade) {
+    case SelfTradePrevention::CancelNewest:
+      sink.onCancelled(id, quantity);
+      quantity = 0;
+      break;
+    case SelfTradePrevention::CancelOldest:
+      sink.onCancelled(own->id, ownRemaining);
+      retire(own);
+      break;
+    case SelfTradePrevention::CancelBoth:
+      sink.onCancelled(own->id, ownRemaining);
+      retire(own);
+      sink.onCancelled(id, quantity);
+      quantity = 0;
+      break;
+    case SelfTradePrevention::Decrement: {
+      int cut = std::min(quantity, ownRemaining);
+      quantity -= cut;
+      if (cut == ownRemaining) {
+        sink.onCancelled(own->id, ownRemaining);
+        retire(own);
+      } else {
+        int fromReserve = std::min(cut, own->hiddenQuantity);
+        own->level->reduceHidden(own, fromReserve);
+        own->level->reduce(own, cut - fromReserve);
+        sink.onModified(own->id, ownRemaining - cut);
+      }
+      sink.onCancelled(id, cut);
+      break;
+    }
+  }
+  return next;
+}
 
-          availableQty += order.quantity;
-          if (availableQty >= quantity) {
-            canFill = true;
-            break;
+template <typename Side>
+int OrderBook::matchLevels(Side& side, int id, Price price, int quantity, long long userId, long long time, ExecutionSink& sink) {
+  auto cursor = side.begin();
+  bool changed = false;
+  Price touch = cursor.level ? cursor.level->price : Price();
+
+  while (cursor.level && side.crosses(price, cursor.level->price) && quantity > 0) {
+    PriceLevel& level = *cursor.level;
+    Order* resting = level.head;
+    int traded = 0;
+    bool selfTraded = false;
+
+    while (resting && quantity > 0) {
+      if (resting->userId == userId) {
+        resting = settleSelfTrade(resting, id, quantity, sink);
+        selfTraded = true;
+        continue;
+      }
+      int tradeQty = std::min(quantity, resting->quantity);
+      sink.onTrade(Trade(resting->id, id, level.price, tradeQty, time));
+      quantity -= tradeQty;
+      traded += tradeQty;
+
+      if (tradeQty == resting->quantity) {
+        Order* filled = resting;
+        resting = resting->next;
+        if (filled->hiddenQuantity) {
+          if (filled->details->displayQuantity > 0) {
+            // The refreshed slice queues behind everything not yet visited.
+            filled->sequence = nextSequence++;
+            level.reduce(filled, tradeQty);
+            level.replenish(filled);
+            if (!resting) resting = filled;
+            continue;
           }
+          // A reserve with no slice size can never be shown; drop it rather
+          // than re-queue an empty slice forever.
+          sink.onCancelled(filled->id, filled->hiddenQuantity);
         }
-        if (canFill) break;
-        ++it;
+        retire(filled);
+      } else {
+        level.reduce(resting, tradeQty);
       }
     }
-
-    if (!canFill) return;
+    if (traded) noteTrade(level.price);
+    if (traded || selfTraded) {
+      publishLevel(Side::IsBidSide, level);
+      changed = true;
+    }
+    if (level.empty()) side.eraseAndAdvance(cursor);
+    else side.advance(cursor);
   }
+  if (changed) refreshTop(Side::IsBidSide, touch);
+  return quantity;
+}
 
-  if(type == orderType::GTC) {
-    orderIdUserId[id] = userId;
-    orderIdPrice[id] = price;
-    orderIdSide[id] = isBuy;
+template <typename Side>
+bool OrderBook::restOrder(Side& side, Order* order, Price price) {
+  if (!orders.insert(order->id, order)) return false;
+  PriceLevel& level = side.levelFor(price);
+  level.pushBack(order);
+  publishLevel(Side::IsBidSide, level);
+  users[order->userId].pushBack(order);
+  refreshTop(Side::IsBidSide, price);
+  return true;
+}
+
+template <orderType Type, bool IsBuy>
+void OrderBook::enterOrder(int id, Price price, int quantity, long long userId, ExecutionSink& sink, int displayQuantity,
+                           long long expireTime) {
+  using Policy = TimeInForce<Type>;
+  if (Policy::Rests && (orders.find(id) || (!stops.empty() && stops.contains(id)))) return;
+
+  auto& opposite = sideOf<!IsBuy>();
+  long long time = now();
+  unsigned long long sequence = nextSequence++;
+  sink.onAccepted(id, price, quantity, IsBuy, userId);
+
+  if constexpr (Policy::Rests) {
+    if (expireTime <= expiries.time()) {
+      sink.onCancelled(id, quantity);
+      return;
+    }
+  }
+  if constexpr (Policy::AllOrNone) {
+    if (!canFill(opposite, price, quantity, userId)) {
+      sink.onCancelled(id, quantity);
+      return;
+    }
   }
-  
-  if (isBuy) {
-    auto it = asks.begin();
 
-    while (it != asks.end() && it->first <= price && quantity > 0) {
-      auto itSet = it->second.begin();
-    
-      while (itSet != it->second.end() && quantity > 0) {
-        if(itSet->userId == userId) {
-          ++itSet;
-          continue;
-        }
-        int curr = itSet->quantity;
-
-        int tradeQty = std::min(quantity, curr);
-        trades.emplace_back(itSet->id, id, it->first, tradeQty, time);
-        
-        if (quantity >= curr) {
-          quantity -= curr;
-          itSet = it->second.erase(itSet);
-        } else {
-          Order updated = *itSet;
-          updated.quantity -= quantity;
-          quantity = 0;
-          itSet = it->second.erase(itSet);
-          it->second.insert(updated);
-          break;
-        }
+  quantity = matchLevels(opposite, id, price, quantity, userId, time, sink);
+  if (quantity <= 0) return;
+
+  if constexpr (Policy::Rests) {
+    Order* order = createOrder(id, quantity, userId, IsBuy, time);
+    order->sequence = sequence;
+    if (displayQuantity > 0) {
+      order->details->displayQuantity = displayQuantity;
+      if (quantity > displayQuantity) {
+        order->hiddenQuantity = quantity - displayQuantity;
+        order->quantity = displayQuantity;
       }
-      if (it->second.empty()) it = asks.erase(it);
-      else ++it;
     }
-    if (quantity > 0 && type == orderType::GTC) bids[price].emplace(id, price, quantity, time, userId);
-  } else { 
-    auto it = bids.begin();
-
-    while (it != bids.end() && it->first >= price && quantity > 0) {
-      auto itSet = it->second.begin();
-    
-      while (itSet != it->second.end() && quantity > 0) {
-        if(itSet->userId == userId) {
-          ++itSet;
-          continue;
-        }
-        int curr = itSet->quantity;
-
-        int tradeQty = std::min(quantity, curr);
-        trades.emplace_back(itSet->id, id, it->first, tradeQty, time);
-        
-        if (quantity >= curr) {
-          quantity -= curr;
-          itSet = it->second.erase(itSet);
-        } else {
-          Order updated = *itSet;
-          updated.quantity -= quantity;
-          quantity = 0;
-          itSet = it->second.erase(itSet);
-          it->second.insert(updated);
-          break;
-        }
-      }
-      if (it->second.empty()) it = bids.erase(it);
-      else ++it;
+    if (!restOrder(sideOf<IsBuy>(), order, price)) {
+      destroyOrder(order);
+      sink.onCancelled(id, quantity);
+      return;
+    }
+    if (expireTime != NoExpiry) {
+      order->details->expireTime = expireTime;
+      expiries.schedule(order->details);
     }
-    if (quantity > 0 && type == orderType::GTC) asks[price].emplace(id, price, quantity, time, userId);
+    sink.onRested(id, price, quantity);
+  } else {
+    sink.onCancelled(id, quantity);
   }
 }
 
-void OrderBook::modifyOrder(int id, Price newPrice, int newQuantity, std::vector<Trade>& trades) {
-  bool isBuy = orderIdSide[id];
-  long long userId = orderIdUserId[id];
+template <orderType Type, bool IsBuy>
+void OrderBook::addOrder(int id, Price price, int quantity, long long userId, ExecutionSink& sink) {
+  enterOrder<Type, IsBuy>(id, price, quantity, userId, sink);
+  if (!(sweepHigh < sweepLow)) releaseStops(sink);
+}
 
-  cancelOrder(id);
-  addOrder(id, newPrice, newQuantity, isBuy, userId, orderType::GTC, trades);
+template void OrderBook::addOrder<orderType::GTC, true>(int, Price, int, long long, ExecutionSink&);
+template void OrderBook::addOrder<orderType::GTC, false>(int, Price, int, long long, ExecutionSink&);
+template void OrderBook::addOrder<orderType::IOC, true>(int, Price, int, long long, ExecutionSink&);
+template void OrderBook::addOrder<orderType::IOC, false>(int, Price, int, long long, ExecutionSink&);
+template void OrderBook::addOrder<orderType::FOK, true>(int, Price, int, long long, ExecutionSink&);
+template void OrderBook::addOrder<orderType::FOK, false>(int, Price, int, long long, ExecutionSink&);
+
+void OrderBook::addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, ExecutionSink& sink) {
+  switch (type) {
+    case orderType::GTC:
+      if (isBuy) addOrder<orderType::GTC, true>(id, price, quantity, userId, sink);
+      else addOrder<orderType::GTC, false>(id, price, quantity, userId, sink);
+      break;
+    case orderType::IOC:
+      if (isBuy) addOrder<orderType::IOC, true>(id, price, quantity, userId, sink);
+      else addOrder<orderType::IOC, false>(id, price, quantity, userId, sink);
+      break;
+    case orderType::FOK:
+      if (isBuy) addOrder<orderType::FOK, true>(id, price, quantity, userId, sink);
+      else addOrder<orderType::FOK, false>(id, price, quantity, userId, sink);
+      break;
+    case orderType::STOP:
+    case orderType::STOP_LIMIT:
+      addStopOrder(id, price, price, quantity, isBuy, userId, type, sink);
+      break;
+    case orderType::GTD:
+    case orderType::DAY:
+      addOrder(id, price, quantity, isBuy, userId, type, NoExpiry, sink);
+      break;
+  }
 }
 
-void OrderBook::cancelOrder(int id) {
-  auto side_it = orderIdSide.find(id);
-  if (side_it == orderIdSide.end()) return;
+void OrderBook::addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, long long expireTime,
+                         ExecutionSink& sink) {
+  if (!expires(type)) addOrder(id, price, quantity, isBuy, userId, type, sink);
+  else enterResting(id, price, quantity, 0, isBuy, userId, expiryOf(type, expireTime), sink);
+}
 
-  bool isBuy = side_it->second;
-  Price price = orderIdPrice[id];
+void OrderBook::enterResting(int id, Price price, int quantity, int displayQuantity, bool isBuy, long long userId, long long expireTime,
+                             ExecutionSink& sink) {
+  if (isBuy) enterOrder<orderType::GTC, true>(id, price, quantity, userId, sink, displayQuantity, expireTime);
+  else enterOrder<orderType::GTC, false>(id, price, quantity, userId, sink, displayQuantity, expireTime);
+  if (!(sweepHigh < sweepLow)) releaseStops(sink);
+}
 
-  Order keyOrder = { id, price, 0, 0, 0 }; 
+void OrderBook::addIcebergOrder(int id, Price price, int quantity, int displayQuantity, bool isBuy, long long userId, ExecutionSink& sink) {
+  enterResting(id, price, quantity, displayQuantity, isBuy, userId, NoExpiry, sink);
+}
 
-  if (isBuy) {
-    auto priceLevelIt = bids.find(price);
-    
-    if (priceLevelIt != bids.end()) {
-      priceLevelIt->second.erase(keyOrder); 
+void OrderBook::addStopOrder(int id, Price stopPrice, Price limitPrice, int quantity, bool isBuy, long long userId, orderType type, ExecutionSink& sink) {
+  if (!isStop(type)) {
+    addOrder(id, limitPrice, quantity, isBuy, userId, type, sink);
+    return;
+  }
+  if (orders.find(id) || stops.contains(id)) return;
 
-      if (priceLevelIt->second.empty()) bids.erase(priceLevelIt);
-    }
+  sink.onAccepted(id, stopPrice, quantity, isBuy, userId);
+  StopOrder stop;
+  stop.id = id;
+  stop.quantity = quantity;
+  stop.stopPrice = stopPrice;
+  stop.limitPrice = limitPrice;
+  stop.userId = userId;
+  stop.sequence = nextSequence++;
+  stop.type = type;
+  stop.isBuy = isBuy;
+
+  if (hasTraded && (isBuy ? lastTrade >= stopPrice : lastTrade <= stopPrice)) enterTriggered(stop, sink);
+  else stops.add(stop);
+}
+
+void OrderBook::enterTriggered(const StopOrder& stop, ExecutionSink& sink) {
+  if (stop.type == orderType::STOP_LIMIT) {
+    addOrder(stop.id, stop.limitPrice, stop.quantity, stop.isBuy, stop.userId, orderType::GTC, sink);
   } else {
-    auto priceLevelIt = asks.find(price);
+    Price market(stop.isBuy ? std::numeric_limits<long long>::max() : std::numeric_limits<long long>::min());
+    addOrder(stop.id, market, stop.quantity, stop.isBuy, stop.userId, orderType::IOC, sink);
+  }
+}
 
-    if (priceLevelIt != asks.end()) {
-      priceLevelIt->second.erase(keyOrder);
+void OrderBook::releaseStops(ExecutionSink& sink) {
+  // Orders entered here come back through addOrder(), which lands here
+  // again; the outer call picks up their trades on its next pass, so a
+  // cascade runs as a loop rather than as recursion.
+  if (releasingStops) return;
+  while (!(sweepHigh < sweepLow)) {
+    Price low = sweepLow;
+    Price high = sweepHigh;
+    sweepLow = Price(std::numeric_limits<long long>::max());
+    sweepHigh = Price(std::numeric_limits<long long>::min());
+    if (!stops.triggeredBy(low, high)) return;
 
-      if (priceLevelIt->second.empty()) asks.erase(priceLevelIt);
+    releasingStops = true;
+    stops.take(low, high, triggered);
+    for (const StopOrder& stop : triggered) enterTriggered(stop, sink);
+    releasingStops = false;
+  }
+}
+
+void OrderBook::modifyOrder(int id, Price newPrice, int newQuantity, ExecutionSink& sink) {
+  Order* order = orders.find(id);
+  if (!order) return;
+
+  if (newQuantity <= 0) {
+    cancelOrder(id, sink);
+    return;
+  }
+
+  // A reduction at the same price is amended in place and keeps priority;
+  // only price changes and increases go back through the queue. An iceberg
+  // gives up reserve before any of its visible slice.
+  int remaining = order->quantity + order->hiddenQuantity;
+  if (newPrice == order->price() && newQuantity <= remaining) {
+    int cut = remaining - newQuantity;
+    int fromReserve = std::min(cut, order->hiddenQuantity);
+    order->level->reduceHidden(order, fromReserve);
+    order->level->reduce(order, cut - fromReserve);
+    publishLevel(order->isBuy, *order->level);
+    refreshTop(order->isBuy, newPrice);
+    sink.onModified(id, newQuantity);
+    return;
+  }
+
+  bool isBuy = order->isBuy;
+  long long userId = order->userId;
+  int displayQuantity = order->details->displayQuantity;
+  long long expireTime = order->details->expireTime;
+
+  cancelOrder(id, sink);
+  enterResting(id, newPrice, newQuantity, displayQuantity, isBuy, userId, expireTime, sink);
+}
+
+void OrderBook::cancelOrder(int id, ExecutionSink& sink) {
+  Order* order = orders.erase(id);
+  if (!order) {
+    StopOrder stop;
+    if (!stops.empty() && stops.remove(id, &stop)) sink.onCancelled(id, stop.quantity);
+    return;
+  }
+
+  sink.onCancelled(id, order->quantity + order->hiddenQuantity);
+  removeResting(order);
+}
+
+size_t OrderBook::cancelOrdersForUser(long long userId, const MassCancelFilter& filter, ExecutionSink& sink) {
+  UserOrders* own = users.find(userId);
+  if (!own) return 0;
+
+  size_t cancelled = 0;
+  bool bidsChanged = false;
+  bool asksChanged = false;
+  // Stops as soon as no order on a wanted side is left, so a one-sided pull
+  // does not walk the other side's tail.
+  for (OrderDetails* details = own->head;
+       details && ((filter.buys && own->buyCount) || (filter.sells && own->countOn(false)));) {
+    Order* order = details->order;
+    details = details->userNext;
+    PriceLevel* level = order->level;
+    if (!filter.matches(order->isBuy, level->price)) continue;
+
+    sink.onCancelled(order->id, order->quantity + order->hiddenQuantity);
+    own->remove(order);
+    level->remove(order);
+    publishLevel(order->isBuy, *level);
+    if (order->isBuy) {
+      bidsChanged = true;
+      if (level->empty()) bids.eraseLevel(level);
+    } else {
+      asksChanged = true;
+      if (level->empty()) asks.eraseLevel(level);
+    }
+    orders.erase(order->id);
+    destroyOrder(order);
+    ++cancelled;
+  }
+
+  if (own->empty()) users.erase(userId);
+  // Passing the current best always forces a recompute of that side.
+  if (bidsChanged) refreshTop(true, top.bid.price);
+  if (asksChanged) refreshTop(false, top.ask.price);
+  return cancelled;
+}
+
+void OrderBook::advanceTime(long long time, ExecutionSink& sink) {
+  // Expiry goes through the ordinary cancel path; the wheel has already
+  // unscheduled the order.
+  expiries.advance(time, [&](OrderDetails* details) { cancelOrder(details->order->id, sink); });
+}
+
+void OrderBook::apply(const Command& command, ExecutionSink& sink) {
+  switch (command.type) {
+    case CommandType::Add:
+      if (command.displayQuantity > 0 && (command.tif == orderType::GTC || expires(command.tif))) {
+        enterResting(command.id, command.price, command.quantity, command.displayQuantity, command.isBuy, command.userId,
+                     expiryOf(command.tif, command.expireTime), sink);
+      } else if (isStop(command.tif)) {
+        addStopOrder(command.id, command.stopPrice, command.price, command.quantity, command.isBuy, command.userId, command.tif, sink);
+      } else {
+        addOrder(command.id, command.price, command.quantity, command.isBuy, command.userId, command.tif, command.expireTime, sink);
+      }
+      break;
+    case CommandType::Cancel:
+      cancelOrder(command.id, sink);
+      break;
+    case CommandType::Modify:
+      modifyOrder(command.id, command.price, command.quantity, sink);
+      break;
+    case CommandType::AdvanceTime:
+      advanceTime(now(), sink);
+      break;
+  }
+}
+
+void OrderBook::applyBatch(const Command* commands, size_t count, ExecutionSink& sink) {
+  // Two-stage prefetch: the index slot well ahead, then the resting node it
+  // points to once that slot has had time to arrive. The second stage reads
+  // only the slot the first one fetched, so it adds no probe of its own.
+  constexpr size_t SlotDistance = 8;
+  constexpr size_t NodeDistance = 4;
+  size_t slots[SlotDistance];
+  for (size_t& slot : slots) slot = OrderIndex::NoSlot;
+
+  // Cleared however the batch ends, so a throwing command cannot leave the
+  // book stamping later events with this batch's time.
+  struct BatchScope {
+    bool& batching;
+    explicit BatchScope(bool& flag) : batching(flag) { batching = true; }
+    ~BatchScope() { batching = false; }
+  };
+
+  batchTime = clock ? clock->now() : 0;
+  BatchScope scope(batching);
+  for (size_t i = 0; i < count; ++i) {
+    if (i + SlotDistance < count) slots[(i + SlotDistance) % SlotDistance] = orders.prefetch(commands[i + SlotDistance].id);
+    if (i + NodeDistance < count && commands[i + NodeDistance].type != CommandType::Add) {
+      const Command& ahead = commands[i + NodeDistance];
+      if (const Order* order = orders.findAt(slots[(i + NodeDistance) % SlotDistance], ahead.id)) __builtin_prefetch(order);
     }
+    apply(commands[i], sink);
+  }
+}
+
+void OrderBook::addOrder(int id, Price price, int quantity, bool isBuy, long long userId, orderType type, std::vector<Trade>& trades) {
+  TradeVectorSink sink(trades);
+  addOrder(id, price, quantity, isBuy, userId, type, sink);
+}
+
+void OrderBook::modifyOrder(int id, Price newPrice, int newQuantity, std::vector<Trade>& trades) {
+  TradeVectorSink sink(trades);
+  modifyOrder(id, newPrice, newQuantity, sink);
+}
+
+void OrderBook::cancelOrder(int id) {
+  NullSink sink;
+  cancelOrder(id, sink);
+}
+
+size_t OrderBook::cancelAllForUser(long long userId) {
+  NullSink sink;
+  return cancelAllForUser(userId, sink);
+}
+
+void OrderBook::advanceTime(long long time) {
+  NullSink sink;
+  advanceTime(time, sink);
+}
+
+void OrderBook::removeResting(Order* order) {
+  PriceLevel* level = order->level;
+  bool isBuy = order->isBuy;
+  Price price = level->price;
+  unlinkUser(order);
+  level->remove(order);
+  publishLevel(isBuy, *level);
+
+  if (level->empty()) {
+    if (isBuy) bids.eraseLevel(level);
+    else asks.eraseLevel(level);
   }
+  destroyOrder(order);
+  refreshTop(isBuy, price);
+}
 
-  orderIdSide.erase(side_it);
-  orderIdUserId.erase(id);
-  orderIdPrice.erase(id);
+template <typename Side>
+static DepthLevel bestOf(const Side& side) {
+  const PriceLevel* level = side.begin().level;
+  return level ? DepthLevel{level->price, level->totalQuantity, level->orderCount} : DepthLevel{};
+}
+
+static bool sameLevel(const DepthLevel& a, const DepthLevel& b) {
+  return a.price == b.price && a.quantity == b.quantity && a.orderCount == b.orderCount;
+}
+
+void OrderBook::refreshTop(bool isBuy, Price changed) {
+  // A change behind the current best cannot move the top of book.
+  DepthLevel& best = isBuy ? top.bid : top.ask;
+  if (best.orderCount && (isBuy ? changed < best.price : changed > best.price)) return;
+
+  DepthLevel current = isBuy ? bestOf(bids) : bestOf(asks);
+  if (sameLevel(current, best)) return;
+  best = current;
+  topFeed.store(top);
+}
+
+void OrderBook::unlinkUser(Order* order) {
+  UserOrders* own = users.find(order->userId);
+  own->remove(order);
+  if (own->empty()) users.erase(order->userId);
+}
+
+size_t OrderBook::depth(bool isBuy, DepthLevel* out, size_t maxLevels) const {
+  size_t n = 0;
+  auto copy = [&](const auto& side) {
+    for (auto cursor = side.begin(); cursor.level && n < maxLevels; side.advance(cursor)) {
+      out[n++] = DepthLevel{cursor.level->price, cursor.level->totalQuantity, cursor.level->orderCount};
+    }
+  };
+  if (isBuy) copy(bids);
+  else copy(asks);
+  return n;
 }
 
 void OrderBook::printOrderBook() const {
   std::cout << "\nBIDS (price desc):\n";
-  for (const auto &[price, orders] : bids) {
-    for (const auto &order : orders) {
-      std::cout << "ID: " << order.id << ", Price: " << price << ", Qty: " << order.quantity << ", Time: " << order.timestamp << '\n';
+  for (auto cursor = bids.begin(); cursor.level; bids.advance(cursor)) {
+    for (const Order* order = cursor.level->head; order; order = order->next) {
+      std::cout << "ID: " << order->id << ", Price: " << order->price() << ", Qty: " << order->quantity << ", Time: " << order->details->timestamp << '\n';
     }
   }
   std::cout << "\nASKS (price asc):\n";
-  for (const auto &[price, orders] : asks) {
-    for (const auto &order : orders) {
-      std::cout << "ID: " << order.id << ", Price: " << price << ", Qty: " << order.quantity << ", Time: " << order.timestamp << '\n';
+  for (auto cursor = asks.begin(); cursor.level; asks.advance(cursor)) {
+    for (const Order* order = cursor.level->head; order; order = order->next) {
+      std::cout << "ID: " << order->id << ", Price: " << order->price() << ", Qty: " << order->quantity << ", Time: " << order->details->timestamp << '\n';
     }
   }
-}
\ No newline at end of file
+}
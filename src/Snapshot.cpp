@@ -0,0 +1,150 @@
+#include "OrderBook.h"
+#include "Snapshot.h"
+#include <cstring>
+#include <stdexcept>
+
+static const char SnapshotMagic[8] = {'O', 'B', 'S', 'N', 'A', 'P', '1', '\0'};
+static const uint32_t SnapshotVersion = 4;
+
+template <typename T>
+static char* put(char* out, const T& value) {
+  std::memcpy(out, &value, sizeof(T));
+  return out + sizeof(T);
+}
+
+template <typename T>
+static const char* take(const char* data, const char* end, T& value) {
+  if (static_cast<size_t>(end - data) < sizeof(T)) throw std::invalid_argument("truncated snapshot");
+  std::memcpy(&value, data, sizeof(T));
+  return data + sizeof(T);
+}
+
+template <typename Side>
+static unsigned long long countLevels(const Side& side) {
+  unsigned long long levels = 0;
+  for (auto cursor = side.begin(); cursor.level; side.advance(cursor)) ++levels;
+  return levels;
+}
+
+template <typename Side>
+char* OrderBook::saveSide(const Side& side, char* out) const {
+  for (auto cursor = side.begin(); cursor.level; side.advance(cursor)) {
+    const PriceLevel& level = *cursor.level;
+    out = put(out, SnapshotLevel{level.price, static_cast<unsigned long long>(level.orderCount)});
+    for (const Order* order = level.head; order; order = order->next) {
+      out = put(out, SnapshotOrder{order->id, order->quantity, order->details->displayQuantity, order->hiddenQuantity,
+                                   order->userId, order->details->timestamp, order->sequence, order->details->expireTime});
+    }
+  }
+  return out;
+}
+
+void OrderBook::saveSnapshot(std::vector<char>& out, unsigned long long journalSequence) const {
+  SnapshotHeader header;
+  std::memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+  header.version = SnapshotVersion;
+  header.hasTraded = hasTraded;
+  header.nextSequence = nextSequence;
+  header.journalSequence = journalSequence;
+  header.orderCount = orders.size();
+  header.bidLevels = countLevels(bids);
+  header.askLevels = countLevels(asks);
+  header.stopCount = stops.size();
+  header.lastTrade = lastTrade;
+  header.time = expiries.time();
+  header.sessionClose = sessionClose;
+
+  // Sized up front so the orders are copied out with no reallocation.
+  size_t start = out.size();
+  out.resize(start + sizeof(header) + (header.bidLevels + header.askLevels) * sizeof(SnapshotLevel) +
+             header.orderCount * sizeof(SnapshotOrder) + header.stopCount * sizeof(SnapshotStop));
+  char* cursor = put(out.data() + start, header);
+  cursor = saveSide(bids, cursor);
+  cursor = saveSide(asks, cursor);
+  stops.forEach([&cursor](const StopOrder& stop) {
+    cursor = put(cursor, SnapshotStop{stop.id, stop.quantity, stop.stopPrice, stop.limitPrice, stop.userId, stop.sequence,
+                                      static_cast<uint32_t>(stop.type), stop.isBuy});
+  });
+}
+
+template <typename Side>
+const char* OrderBook::restoreSide(Side& side, bool isBuy, unsigned long long levels, const char* data, const char* end) {
+  bool first = true;
+  Price previous;
+  for (unsigned long long i = 0; i < levels; ++i) {
+    SnapshotLevel saved;
+    data = take(data, end, saved);
+    if (saved.orderCount == 0) throw std::invalid_argument("empty level in snapshot");
+    if (!first && !(Side::IsBidSide ? saved.price < previous : saved.price > previous)) {
+      throw std::invalid_argument("snapshot levels out of order");
+    }
+    first = false;
+    previous = saved.price;
+
+    PriceLevel& level = side.appendLevel(saved.price);
+    for (unsigned long long n = 0; n < saved.orderCount; ++n) {
+      SnapshotOrder entry;
+      data = take(data, end, entry);
+      if (entry.quantity <= 0 || entry.hiddenQuantity < 0) throw std::invalid_argument("bad quantity in snapshot");
+      if (entry.hiddenQuantity > 0 && (entry.displayQuantity <= 0 || entry.quantity > entry.displayQuantity)) {
+        throw std::invalid_argument("bad iceberg in snapshot");
+      }
+
+      Order* order = createOrder(entry.id, entry.quantity, entry.userId, isBuy, entry.timestamp);
+      order->sequence = entry.sequence;
+      order->details->displayQuantity = entry.displayQuantity;
+      order->hiddenQuantity = entry.hiddenQuantity;
+      if (!orders.insert(entry.id, order)) {
+        destroyOrder(order);
+        throw std::invalid_argument("duplicate order id in snapshot");
+      }
+      level.pushBack(order);
+      users[entry.userId].pushBack(order);
+      if (entry.expireTime != NoExpiry) {
+        order->details->expireTime = entry.expireTime;
+        expiries.schedule(order->details);
+      }
+    }
+  }
+  return data;
+}
+
+unsigned long long OrderBook::restoreSnapshot(const char* data, size_t size) {
+  if (orders.size() != 0 || !stops.empty()) throw std::invalid_argument("snapshot must be restored into an empty book");
+
+  const char* end = data + size;
+  SnapshotHeader header;
+  data = take(data, end, header);
+  if (std::memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0 || header.version != SnapshotVersion) {
+    throw std::invalid_argument("not an order book snapshot");
+  }
+  if (header.orderCount > size / sizeof(SnapshotOrder)) throw std::invalid_argument("truncated snapshot");
+
+  orders.reserve(header.orderCount);
+  expiries.reset(header.time);
+  data = restoreSide(bids, true, header.bidLevels, data, end);
+  data = restoreSide(asks, false, header.askLevels, data, end);
+  for (unsigned long long i = 0; i < header.stopCount; ++i) {
+    SnapshotStop saved;
+    data = take(data, end, saved);
+    StopOrder stop;
+    stop.id = saved.id;
+    stop.quantity = saved.quantity;
+    stop.stopPrice = saved.stopPrice;
+    stop.limitPrice = saved.limitPrice;
+    stop.userId = saved.userId;
+    stop.sequence = saved.sequence;
+    stop.type = static_cast<orderType>(saved.type);
+    stop.isBuy = saved.isBuy != 0;
+    if (!isStop(stop.type) || orders.find(stop.id) || !stops.add(stop)) throw std::invalid_argument("bad stop order in snapshot");
+  }
+  if (data != end || orders.size() != header.orderCount) throw std::invalid_argument("snapshot size mismatch");
+
+  nextSequence = header.nextSequence;
+  hasTraded = header.hasTraded != 0;
+  lastTrade = header.lastTrade;
+  sessionClose = header.sessionClose;
+  if (const PriceLevel* best = bids.begin().level) refreshTop(true, best->price);
+  if (const PriceLevel* best = asks.begin().level) refreshTop(false, best->price);
+  return header.journalSequence;
+}
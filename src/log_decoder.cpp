@@ -0,0 +1,68 @@
+#include "EventLog.h"
+#include "TradeLogSink.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// Renders a binary event log as text, one event per line. With --trades only
+// the trades are written, in the simulator's old log.txt format, so the
+// output can be compared with OrderBookReplay's trade log.
+int main(int argc, char** argv) {
+  bool tradesOnly = false;
+  std::vector<const char*> paths;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--trades") == 0) tradesOnly = true;
+    else paths.push_back(argv[i]);
+  }
+  if (paths.empty() || paths.size() > 2) {
+    std::cerr << "usage: " << argv[0] << " [--trades] <event-log> [text-out]\n";
+    return 2;
+  }
+
+  try {
+    EventLogReader log(paths[0]);
+    std::ofstream file;
+    if (paths.size() > 1) {
+      file.open(paths[1]);
+      if (!file) throw std::runtime_error(std::string("cannot write ") + paths[1]);
+    }
+    std::ostream& out = paths.size() > 1 ? file : std::cout;
+    std::ios::sync_with_stdio(false);
+    TradeLogSink trades(out);
+
+    for (const ExecutionReport& report : log) {
+      if (report.type == ReportType::Trade) {
+        if (!tradesOnly) out << "trade ";
+        trades.onTrade(Trade(report.contraId, report.id, report.price, report.quantity, report.timestamp));
+        continue;
+      }
+      if (tradesOnly) continue;
+
+      switch (report.type) {
+        case ReportType::Accepted:
+          out << "accepted id: " << report.id << (report.isBuy ? " buy" : " sell") << " price: " << report.price
+              << " quantity: " << report.quantity << " user: " << report.userId;
+          break;
+        case ReportType::Rested:
+          out << "rested id: " << report.id << " price: " << report.price << " quantity: " << report.quantity;
+          break;
+        case ReportType::Cancelled:
+          out << "cancelled id: " << report.id << " quantity: " << report.quantity;
+          break;
+        case ReportType::Modified:
+          out << "modified id: " << report.id << " quantity: " << report.quantity;
+          break;
+        case ReportType::Trade:
+          break;
+      }
+      out << " time: " << report.timestamp << "\n";
+    }
+    out.flush();
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
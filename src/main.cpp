@@ -1,10 +1,13 @@
-#include "Trade.h"
+#include "Clock.h"
+#include "Command.h"
+#include "EventLog.h"
+#include "ExecutionReport.h"
+#include "Journal.h"
 #include "Order.h"
 #include "OrderBook.h"
 #include <unordered_set>
 #include <sys/stat.h>
 #include <iostream>
-#include <fstream>
 #include <random>
 #include <vector>
 #include <cmath>
@@ -13,13 +16,26 @@ int main() {
   std::string outDir = "../out";
   mkdir(outDir.c_str(), 0777);
 
-  std::ofstream logFile((outDir + "/log.txt").c_str());
-  std::cout.rdbuf(logFile.rdbuf());
-
-
-
+  // Every command is stamped and journaled before it is applied, so
+  // OrderBookReplay can rebuild the book and reproduce its trades exactly.
+  // Events go to a binary log written off this thread; OrderBookLogDecoder
+  // renders it as text.
+  // OrderBookReplay applies the journal under the same self-trade mode.
   OrderBook book;
-  std::vector<Trade> trades;
+  book.setSelfTradePrevention(SelfTradePrevention::CancelNewest);
+  TscClock ingress;
+  ManualClock clock;
+  book.setClock(&clock);
+  EventLogWriter eventLog(outDir + "/events.bin");
+  ReportSink<LogReports> sink(LogReports{&eventLog});
+  JournalWriter journal(outDir + "/journal.bin");
+  auto submit = [&](Command command) {
+    command.timestamp = ingress.now();
+    journal.append(command);
+    clock.set(command.timestamp);
+    sink.timestamp = command.timestamp;
+    book.apply(command, sink);
+  };
 
   std::random_device rd;
   std::mt19937 gen(rd());
@@ -49,13 +65,13 @@ int main() {
       double newPrice = currentPrice + newPriceMove(gen);
       newPrice = std::round(newPrice * 100.0) / 100.0;
       int newQty = newQtyGen(gen);
-      book.modifyOrder(modID, newPrice, newQty, trades);
+      submit(Command::modify(modID, newPrice, newQty));
     } else if (!idVec.empty() && r < 0.6) {
       // Cancel order 30% of the time (0.3-0.6)
       std::uniform_int_distribution<> activeIdGen(0, static_cast<int>(idVec.size()) - 1);
       int idx = activeIdGen(gen);
       int cancelID = idVec[idx];
-      book.cancelOrder(cancelID);
+      submit(Command::cancel(cancelID));
       activeOrderIds.erase(cancelID);
       idVec[idx] = idVec.back();
       idVec.pop_back();
@@ -65,18 +81,17 @@ int main() {
       currentPrice = std::round(currentPrice * 100.0) / 100.0;
       int qty = qtyGen(gen);
       bool isBuy = sideGen(gen) == 0;
-      book.addOrder(nextOrderId, currentPrice, qty, isBuy, usrId(gen), orderType::GTC, trades);
+      submit(Command::add(nextOrderId, currentPrice, qty, isBuy, usrId(gen)));
       activeOrderIds.insert(nextOrderId);
       idVec.push_back(nextOrderId);
       ++nextOrderId;
     }
   }
 
-  std::cin.tie(NULL)->sync_with_stdio(false);
-  for(auto i = trades.begin(); i != trades.end(); ++i) {
-    std::cout << "passive: " << i->passiveId << " agressive: " << i->agressiveId << " price: " << i->price
-              << " quantity: " << i->quantity << " time: " << i->timestamp << "\n";
+  eventLog.close();
+  if (eventLog.failed()) {
+    std::cerr << "writing " << outDir << "/events.bin failed\n";
+    return 1;
   }
-
   return 0;
 }
\ No newline at end of file
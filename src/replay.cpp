@@ -0,0 +1,46 @@
+#include "Journal.h"
+#include "OrderBook.h"
+#include "TradeLogSink.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// Rebuilds an order book from a command journal. With an output path the
+// trades are written in the same format as the simulator's log, so the two
+// files can be compared directly.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <journal> [trade-log]\n";
+    return 2;
+  }
+
+  try {
+    JournalReader journal(argv[1]);
+    OrderBook book;
+    // The mode the simulator records under; trades only replay under it.
+    book.setSelfTradePrevention(SelfTradePrevention::CancelNewest);
+
+    std::ofstream logFile;
+    NullSink nullSink;
+    TradeLogSink logSink(logFile);
+    ExecutionSink* sink = &nullSink;
+    if (argc > 2) {
+      logFile.open(argv[2]);
+      if (!logFile) throw std::runtime_error(std::string("cannot write ") + argv[2]);
+      sink = &logSink;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t applied = replayJournal(journal, book, *sink);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "replayed " << applied << " commands in " << seconds << " s ("
+              << static_cast<long long>(applied / (seconds > 0 ? seconds : 1)) << " commands/s), "
+              << book.restingOrderCount() << " orders resting\n";
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+#include "OrderBook.h"
+#include "Trade.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Counts every call into the global heap made by this test binary.
+static std::atomic<long long> heapAllocations{0};
+
+void* operator new(std::size_t size) {
+  ++heapAllocations;
+  void* ptr = std::malloc(size ? size : 1);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  ++heapAllocations;
+  size_t align = static_cast<size_t>(alignment);
+  void* ptr = std::aligned_alloc(align, (size + align - 1) & ~(align - 1));
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+// One round of the hot-path workload: rest orders on both sides across a few
+// levels near the touch, cross some of them, and cancel the rest.
+static void churn(OrderBook& book, std::vector<Trade>& trades, int& nextId) {
+  int first = nextId;
+  for (int i = 0; i < 200; ++i) {
+    bool isBuy = i % 2 == 0;
+    double price = isBuy ? 99.9 - (i % 10) * 0.01 : 100.1 + (i % 10) * 0.01;
+    book.addOrder(nextId++, price, 10, isBuy, 1000 + i, orderType::GTC, trades);
+  }
+  book.addOrder(nextId++, 100.2, 150, true, 1, orderType::IOC, trades);
+  book.addOrder(nextId++, 99.8, 150, false, 1, orderType::IOC, trades);
+  for (int id = first; id < nextId; ++id) book.cancelOrder(id);
+  trades.clear();
+}
+
+static long long allocationsDuringChurn(OrderBook& book) {
+  std::vector<Trade> trades;
+  trades.reserve(1024);
+  int nextId = 1;
+
+  for (int round = 0; round < 3; ++round) churn(book, trades, nextId);
+
+  long long before = heapAllocations;
+  for (int round = 0; round < 10; ++round) churn(book, trades, nextId);
+  return heapAllocations - before;
+}
+
+TEST(AllocationTest, PoolPolicyHotPathIsAllocationFreeAfterWarmUp) {
+  OrderBook book;
+
+  EXPECT_EQ(allocationsDuringChurn(book), 0);
+}
+
+TEST(AllocationTest, LadderModeHotPathIsAllocationFreeAfterWarmUp) {
+  OrderBook book(LadderConfig{90.0, 110.0, 1});
+
+  EXPECT_EQ(allocationsDuringChurn(book), 0);
+}
+
+TEST(AllocationTest, HeapPolicyAllocatesPerOrder) {
+  OrderBook book(std::make_unique<HeapAllocationPolicy>());
+
+  EXPECT_GT(allocationsDuringChurn(book), 0);
+}
+
+TEST(AllocationTest, DepthFeedPublishesWithoutAllocating) {
+  OrderBook book;
+  DepthFeed feed;
+  book.setDepthFeed(&feed);
+
+  EXPECT_EQ(allocationsDuringChurn(book), 0);
+  EXPECT_GT(feed.size(), 0);
+}
+
+TEST(AllocationTest, PoolPolicyPacksOneOrderPerCacheLine) {
+  PoolAllocationPolicy policy;
+  std::vector<void*> blocks;
+  for (int i = 0; i < 64; ++i) blocks.push_back(policy.allocateOrder());
+
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(blocks[i]) % CacheLineSize, 0);
+    if (i) {
+      EXPECT_EQ(static_cast<char*>(blocks[i]) - static_cast<char*>(blocks[i - 1]), static_cast<ptrdiff_t>(CacheLineSize));
+    }
+  }
+  for (void* block : blocks) policy.deallocateOrder(block);
+}
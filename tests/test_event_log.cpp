@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "EventLog.h"
+#include "OrderBook.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::string logPath(const char* name) { return ::testing::TempDir() + name; }
+
+static void expectSameReports(const EventLogReader& log, const std::vector<ExecutionReport>& expected) {
+  ASSERT_EQ(log.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(log[i].type, expected[i].type);
+    EXPECT_EQ(log[i].id, expected[i].id);
+    EXPECT_EQ(log[i].contraId, expected[i].contraId);
+    EXPECT_EQ(log[i].quantity, expected[i].quantity);
+    EXPECT_EQ(log[i].price, expected[i].price);
+    EXPECT_EQ(log[i].timestamp, expected[i].timestamp);
+  }
+}
+
+TEST(EventLogTest, RecordsEveryBookEventInOrder) {
+  std::string path = logPath("book.events");
+  std::mt19937 gen(11);
+  std::vector<ExecutionReport> expected;
+  {
+    EventLogWriter log(path);
+    ReportSink<LogReports> logSink(LogReports{&log});
+    ReportSink<AppendReports> memorySink(AppendReports{&expected});
+    OrderBook logged;
+    OrderBook reference;
+    for (int i = 0; i < 20000; ++i) {
+      Command command = i % 4 == 3 ? Command::cancel(1 + gen() % i)
+                                   : Command::add(i + 1, Price(10000LL + static_cast<int>(gen() % 21) - 10), 1 + gen() % 20, gen() % 2 == 0, gen() % 50);
+      logSink.timestamp = memorySink.timestamp = i;
+      logged.apply(command, logSink);
+      reference.apply(command, memorySink);
+    }
+    log.close();
+    EXPECT_EQ(log.written(), expected.size());
+    EXPECT_FALSE(log.failed());
+  }
+
+  EventLogReader log(path);
+  expectSameReports(log, expected);
+  std::remove(path.c_str());
+}
+
+TEST(EventLogTest, FullRingStallsInsteadOfDropping) {
+  std::string path = logPath("stall.events");
+  std::vector<ExecutionReport> expected;
+  EventLogWriter::Config config;
+  config.ringCapacity = 8;
+  config.bufferBytes = 64 * sizeof(ExecutionReport);
+  {
+    EventLogWriter log(path, config);
+    for (int i = 0; i < 50000; ++i) {
+      ExecutionReport report;
+      report.type = ReportType::Trade;
+      report.id = i;
+      report.contraId = -i;
+      report.quantity = i % 100;
+      report.timestamp = i;
+      expected.push_back(report);
+      log.log(report);
+    }
+  }
+
+  EventLogReader log(path);
+  expectSameReports(log, expected);
+  std::remove(path.c_str());
+}
+
+TEST(EventLogTest, QuietRingIsFlushedWithoutClosing) {
+  std::string path = logPath("quiet.events");
+  EventLogWriter::Config config;
+  config.flushIntervalMicros = 100;
+  EventLogWriter log(path, config);
+  ExecutionReport report;
+  report.id = 42;
+  log.log(report);
+  for (int i = 0; i < 2000 && log.written() == 0; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  EXPECT_EQ(log.written(), 1);
+
+  EventLogReader reader(path);
+  ASSERT_EQ(reader.size(), 1);
+  EXPECT_EQ(reader[0].id, 42);
+  log.close();
+  std::remove(path.c_str());
+}
+
+TEST(EventLogTest, ReaderRejectsOtherFiles) {
+  std::string path = logPath("foreign.events");
+  {
+    std::ofstream out(path);
+    out << "passive: 1 agressive: 2 price: 100 quantity: 5 time: 0\n";
+  }
+  EXPECT_THROW(EventLogReader reader(path), std::runtime_error);
+  std::remove(path.c_str());
+  EXPECT_THROW(EventLogReader reader(path), std::runtime_error);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include "Journal.h"
+#include "MatchingThread.h"
+#include "OrderBook.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+static std::string journalPath(const char* name) { return ::testing::TempDir() + name; }
+
+// Add/cancel/modify walk with increasing timestamps.
+static std::vector<Command> randomCommands(int count) {
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<> tick(-20, 20);
+  std::vector<Command> commands;
+  int nextId = 1;
+  for (int i = 0; i < count; ++i) {
+    int action = gen() % 10;
+    Command command;
+    if (nextId > 1 && action < 2) {
+      command = Command::cancel(1 + gen() % (nextId - 1));
+    } else if (nextId > 1 && action < 4) {
+      command = Command::modify(1 + gen() % (nextId - 1), Price(10000LL + tick(gen)), 1 + gen() % 50);
+    } else {
+      command = Command::add(nextId++, Price(10000LL + tick(gen)), 1 + gen() % 50, gen() % 2 == 0, gen() % 100);
+    }
+    command.timestamp = 1000 + i * 10;
+    commands.push_back(command);
+  }
+  return commands;
+}
+
+static void expectSameTrades(const std::vector<Trade>& a, const std::vector<Trade>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].passiveId, b[i].passiveId);
+    EXPECT_EQ(a[i].agressiveId, b[i].agressiveId);
+    EXPECT_EQ(a[i].price, b[i].price);
+    EXPECT_EQ(a[i].quantity, b[i].quantity);
+    EXPECT_EQ(a[i].timestamp, b[i].timestamp);
+  }
+}
+
+TEST(JournalTest, RoundTripsRecordsInOrder) {
+  std::string path = journalPath("roundtrip.journal");
+  std::vector<Command> commands = randomCommands(5000);
+  {
+    JournalWriter::Config config;
+    config.groupCommit = 64;
+    config.growBytes = 4096;  // force the mapping to grow many times
+    JournalWriter writer(path, config);
+    for (size_t i = 0; i < commands.size(); ++i) EXPECT_EQ(writer.append(commands[i]), i + 1);
+  }
+
+  JournalReader reader(path);
+  ASSERT_EQ(reader.size(), commands.size());
+  for (size_t i = 0; i < commands.size(); ++i) {
+    EXPECT_EQ(reader[i].sequence, i + 1);
+    EXPECT_EQ(reader[i].command.id, commands[i].id);
+    EXPECT_EQ(reader[i].command.type, commands[i].type);
+    EXPECT_EQ(reader[i].command.timestamp, commands[i].timestamp);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(JournalTest, ReplayReproducesTrades) {
+  std::string path = journalPath("replay.journal");
+  std::vector<Command> commands = randomCommands(20000);
+
+  std::vector<Trade> original;
+  OrderBook live;
+  ManualClock clock;
+  live.setClock(&clock);
+  TradeVectorSink liveSink(original);
+  {
+    JournalWriter writer(path);
+    for (const Command& command : commands) {
+      writer.append(command);
+      clock.set(command.timestamp);
+      live.apply(command, liveSink);
+    }
+  }
+  ASSERT_FALSE(original.empty());
+
+  std::vector<Trade> replayed;
+  OrderBook rebuilt;
+  TradeVectorSink replaySink(replayed);
+  JournalReader reader(path);
+  EXPECT_EQ(replayJournal(reader, rebuilt, replaySink), commands.size());
+
+  expectSameTrades(original, replayed);
+  EXPECT_EQ(rebuilt.restingOrderCount(), live.restingOrderCount());
+  EXPECT_EQ(rebuilt.sequence(), live.sequence());
+  std::remove(path.c_str());
+}
+
+TEST(JournalTest, ReaderStopsAtTornTail) {
+  std::string path = journalPath("torn.journal");
+  {
+    JournalWriter writer(path);
+    for (int i = 0; i < 10; ++i) writer.append(Command::add(i, 100.0, 1, true, 1));
+  }
+  {
+    // A half-written record followed by preallocated zeros, as after a crash.
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    JournalRecord torn{};
+    torn.sequence = 11;
+    out.write(reinterpret_cast<const char*>(&torn), sizeof(torn) / 2);
+    std::vector<char> zeros(4096, 0);
+    out.write(zeros.data(), zeros.size());
+  }
+
+  JournalReader reader(path);
+  EXPECT_EQ(reader.size(), 10);
+  std::remove(path.c_str());
+}
+
+TEST(JournalTest, RejectsForeignFiles) {
+  std::string path = journalPath("foreign.journal");
+  {
+    std::ofstream out(path);
+    out << "passive: 1 agressive: 2 price: 100.00 quantity: 5 time: 0\n";
+  }
+  EXPECT_THROW(JournalReader{path}, std::runtime_error);
+  EXPECT_THROW(JournalReader{journalPath("missing.journal")}, std::runtime_error);
+  std::remove(path.c_str());
+}
+
+TEST(JournalTest, MatchingThreadWritesAheadOfApplying) {
+  std::string path = journalPath("thread.journal");
+  std::vector<Command> commands = randomCommands(5000);
+  std::vector<ExecutionReport> reports;
+  {
+    JournalWriter writer(path);
+    MatchingThread engine(MatchingThread::Config{});
+    engine.setJournal(&writer);
+    engine.start();
+    ExecutionReport report;
+    for (const Command& command : commands) {
+      while (!engine.submit(0, command)) {
+        while (engine.poll(report)) reports.push_back(report);
+      }
+    }
+    engine.stop();
+    while (engine.poll(report)) reports.push_back(report);
+  }
+
+  std::vector<Trade> replayed;
+  OrderBook rebuilt;
+  TradeVectorSink sink(replayed);
+  JournalReader reader(path);
+  ASSERT_EQ(reader.size(), commands.size());
+  replayJournal(reader, rebuilt, sink);
+
+  std::vector<Trade> original;
+  for (const ExecutionReport& report : reports) {
+    if (report.type == ReportType::Trade) {
+      original.emplace_back(report.contraId, report.id, report.price, report.quantity, report.timestamp);
+    }
+  }
+  expectSameTrades(original, replayed);
+  std::remove(path.c_str());
+}
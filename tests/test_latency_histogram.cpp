@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+#include "LatencyHistogram.h"
+
+TEST(LatencyHistogramTest, ReportsPercentilesWithinPrecision) {
+  LatencyHistogram histogram;
+  for (int value = 1; value <= 10000; ++value) histogram.record(value);
+
+  EXPECT_EQ(histogram.count(), 10000);
+  EXPECT_EQ(histogram.max(), 10000);
+  EXPECT_NEAR(histogram.mean(), 5000.5, 1e-6);
+  EXPECT_NEAR(histogram.percentile(50.0), 5000, 5000 / 64);
+  EXPECT_NEAR(histogram.percentile(99.0), 9900, 9900 / 64);
+  EXPECT_NEAR(histogram.percentile(99.9), 9990, 9990 / 64);
+  EXPECT_EQ(histogram.percentile(100.0), 10000);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExactAndMergeAddsCounts) {
+  LatencyHistogram a, b;
+  a.record(3);
+  a.record(100);
+  b.record(7);
+  b.record(1LL << 50);  // clamped rather than dropped
+
+  a.merge(b);
+  EXPECT_EQ(a.count(), 4);
+  EXPECT_EQ(a.percentile(25.0), 3);
+  EXPECT_EQ(a.percentile(50.0), 7);
+  EXPECT_EQ(a.percentile(75.0), 100);
+  EXPECT_GT(a.percentile(100.0), 1LL << 39);
+
+  a.reset();
+  EXPECT_EQ(a.count(), 0);
+  EXPECT_EQ(a.percentile(99.0), 0);
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include "MatchingEngine.h"
+#include "MatchingThread.h"
+#include "SpscRing.h"
+#include <thread>
+#include <vector>
+
+TEST(SpscRingTest, PushPopInOrderUntilFull) {
+  SpscRing<int> ring(4);
+  int value = 0;
+
+  EXPECT_FALSE(ring.tryPop(value));
+  for (int i = 0; i < 4; ++i) EXPECT_TRUE(ring.tryPush(i));
+  EXPECT_FALSE(ring.tryPush(4));
+
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(ring.tryPop(value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, RejectsNonPowerOfTwoCapacity) {
+  EXPECT_THROW(SpscRing<int>(6), std::invalid_argument);
+}
+
+TEST(SpscRingTest, TransfersAcrossThreadsInOrder) {
+  SpscRing<int> ring(64);
+  const int count = 200000;
+
+  std::thread producer([&] {
+    for (int i = 0; i < count; ++i) {
+      while (!ring.tryPush(i)) std::this_thread::yield();
+    }
+  });
+
+  int batch[16];
+  int expected = 0;
+  bool ordered = true;
+  while (expected < count) {
+    size_t n = ring.popBatch(batch, 16);
+    for (size_t i = 0; i < n; ++i) ordered = ordered && batch[i] == expected++;
+    if (!n) std::this_thread::yield();
+  }
+  producer.join();
+
+  EXPECT_TRUE(ordered);
+}
+
+static std::vector<ExecutionReport> drain(MatchingThread& engine) {
+  std::vector<ExecutionReport> reports;
+  ExecutionReport report;
+  while (engine.poll(report)) reports.push_back(report);
+  return reports;
+}
+
+TEST(MatchingThreadTest, MatchesCommandsFromSeveralProducers) {
+  MatchingThread::Config config;
+  config.producers = 2;
+  MatchingThread engine(config);
+  engine.start();
+
+  Command sell = Command::add(1, 100.0, 10, false, 1001);
+  sell.timestamp = 500;
+  ASSERT_TRUE(engine.submit(0, sell));
+  while (engine.processed() < 1) std::this_thread::yield();
+
+  Command buy = Command::add(2, 100.0, 10, true, 1002);
+  buy.timestamp = 700;
+  ASSERT_TRUE(engine.submit(1, buy));
+  engine.stop();
+
+  std::vector<ExecutionReport> reports = drain(engine);
+  ASSERT_EQ(reports.size(), 4);
+  EXPECT_EQ(reports[0].type, ReportType::Accepted);
+  EXPECT_EQ(reports[1].type, ReportType::Rested);
+  EXPECT_EQ(reports[2].type, ReportType::Accepted);
+  EXPECT_EQ(reports[3].type, ReportType::Trade);
+  EXPECT_EQ(reports[3].id, 2);
+  EXPECT_EQ(reports[3].contraId, 1);
+  EXPECT_EQ(reports[3].timestamp, 700);
+  EXPECT_EQ(engine.book().restingOrderCount(), 0);
+}
+
+TEST(MatchingThreadTest, StopDrainsQueuedCommands) {
+  MatchingThread engine(MatchingThread::Config{});
+  engine.start();
+
+  for (int i = 0; i < 1000; ++i) {
+    while (!engine.submit(0, Command::add(i, 100.0, 1, true, 1001))) std::this_thread::yield();
+  }
+  engine.submit(0, Command::cancel(0));
+  engine.submit(0, Command::modify(1, 100.0, 0));
+  engine.stop();
+
+  EXPECT_EQ(engine.processed(), 1002);
+  EXPECT_EQ(engine.book().restingOrderCount(), 998);
+}
+
+TEST(MatchingThreadTest, RoutesCommandsByInstrument) {
+  MatchingThread engine(MatchingThread::Config{});
+  ASSERT_TRUE(engine.addBook(7, std::make_unique<OrderBook>()));
+  EXPECT_FALSE(engine.addBook(7, std::make_unique<OrderBook>()));
+  engine.start();
+
+  Command sell = Command::add(1, 100.0, 10, false, 1001);
+  sell.instrument = 7;
+  engine.submit(0, sell);
+  engine.submit(0, Command::add(2, 100.0, 10, true, 1002));
+  Command unknown = Command::add(3, 100.0, 10, true, 1002);
+  unknown.instrument = 9;
+  engine.submit(0, unknown);
+  engine.stop();
+
+  EXPECT_EQ(engine.processed(), 3);
+  EXPECT_EQ(engine.book(7)->restingOrderCount(), 1);
+  EXPECT_EQ(engine.book().restingOrderCount(), 1);
+  EXPECT_EQ(engine.book(9), nullptr);
+  for (const ExecutionReport& report : drain(engine)) EXPECT_NE(report.type, ReportType::Trade);
+}
+
+static std::vector<ExecutionReport> drain(MatchingEngine& engine) {
+  std::vector<ExecutionReport> reports;
+  ExecutionReport report;
+  while (engine.poll(report)) reports.push_back(report);
+  return reports;
+}
+
+TEST(MatchingEngineTest, ShardAssignmentIsStable) {
+  MatchingEngine::Config config;
+  config.shards = 4;
+  MatchingEngine a(config), b(config);
+
+  std::vector<int> used(4, 0);
+  for (uint32_t instrument = 0; instrument < 1000; ++instrument) {
+    EXPECT_EQ(a.shardOf(instrument), b.shardOf(instrument));
+    ++used[a.shardOf(instrument)];
+  }
+  for (int count : used) EXPECT_GT(count, 150);
+}
+
+TEST(MatchingEngineTest, MatchesWithinEachInstrumentOnly) {
+  MatchingEngine::Config config;
+  config.shards = 2;
+  MatchingEngine engine(config);
+  for (uint32_t instrument = 0; instrument < 8; ++instrument) ASSERT_TRUE(engine.addInstrument(instrument));
+  engine.start();
+
+  for (uint32_t instrument = 0; instrument < 8; ++instrument) {
+    Command sell = Command::add(instrument, 100.0, 10, false, 1001);
+    sell.instrument = instrument;
+    ASSERT_TRUE(engine.submit(0, sell));
+  }
+  Command buy = Command::add(100, 100.0, 10, true, 1002);
+  buy.instrument = 3;
+  ASSERT_TRUE(engine.submit(0, buy));
+  engine.stop();
+
+  int trades = 0;
+  for (const ExecutionReport& report : drain(engine)) {
+    if (report.type != ReportType::Trade) continue;
+    ++trades;
+    EXPECT_EQ(report.instrument, 3);
+    EXPECT_EQ(report.contraId, 3);
+  }
+  EXPECT_EQ(trades, 1);
+  for (uint32_t instrument = 0; instrument < 8; ++instrument) {
+    EXPECT_EQ(engine.book(instrument)->restingOrderCount(), instrument == 3 ? 0 : 1);
+  }
+}
+
+TEST(MatchingEngineTest, RoutesCancelAndModifyThroughDirectory) {
+  MatchingEngine::Config config;
+  config.shards = 3;
+  config.directoryCapacity = 16;
+  MatchingEngine engine(config);
+  engine.addInstrument(5);
+  engine.addInstrument(6);
+  engine.start();
+
+  Command low = Command::add(1, 100.0, 10, true, 1001);
+  low.instrument = 5;
+  Command high = Command::add(1000000, 101.0, 10, true, 1001);  // beyond the dense range
+  high.instrument = 6;
+  ASSERT_TRUE(engine.submit(0, low));
+  ASSERT_TRUE(engine.submit(0, high));
+
+  EXPECT_TRUE(engine.submit(0, Command::modify(1, 100.0, 4)));
+  EXPECT_TRUE(engine.submit(0, Command::cancel(1000000)));
+  EXPECT_FALSE(engine.submit(0, Command::cancel(1000000)));
+  EXPECT_FALSE(engine.submit(0, Command::cancel(42)));
+  engine.stop();
+
+  bool modified = false, cancelled = false;
+  for (const ExecutionReport& report : drain(engine)) {
+    if (report.type == ReportType::Modified) modified = report.instrument == 5 && report.quantity == 4;
+    if (report.type == ReportType::Cancelled) cancelled = report.instrument == 6 && report.id == 1000000;
+  }
+  EXPECT_TRUE(modified);
+  EXPECT_TRUE(cancelled);
+  EXPECT_EQ(engine.book(5)->restingOrderCount(), 1);
+  EXPECT_EQ(engine.book(6)->restingOrderCount(), 0);
+}
+
+TEST(MatchingEngineTest, RejectedAddLeavesNoDirectoryEntry) {
+  MatchingEngine::Config config;
+  config.inboundCapacity = 4;
+  MatchingEngine engine(config);
+  engine.addInstrument(5);
+
+  // Not started, so the inbound ring fills up and the next add bounces.
+  int id = 1;
+  for (;; ++id) {
+    Command add = Command::add(id, 100.0, 10, true, 1001);
+    add.instrument = 5;
+    if (!engine.submit(0, add)) break;
+  }
+  // Drain the ring so the cancels below are judged by the directory alone.
+  engine.start();
+  engine.stop();
+  EXPECT_FALSE(engine.submit(0, Command::cancel(id)));
+  EXPECT_TRUE(engine.submit(0, Command::cancel(id - 1)));
+}
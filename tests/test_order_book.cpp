@@ -1,7 +1,18 @@
 #include <gtest/gtest.h>
 #include "OrderBook.h"
+#include "ExecutionReport.h"
+#include "ExecutionSink.h"
 #include "Order.h"
 #include "Trade.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 class OrderBookTest : public ::testing::Test {
@@ -144,6 +155,20 @@ TEST_F(OrderBookTest, PartialFillMultiplePartials) {
   EXPECT_EQ(trades[1].quantity, 5);
 }
 
+TEST_F(OrderBookTest, PartialFillKeepsQueuePriority) {
+  book.addOrder(1, 100.0, 50, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 50, false, 1002, orderType::GTC, trades);
+
+  book.addOrder(3, 100.0, 20, true, 1003, orderType::GTC, trades);
+  book.addOrder(4, 100.0, 40, true, 1004, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 3);
+  EXPECT_EQ(trades[1].passiveId, 1);
+  EXPECT_EQ(trades[1].quantity, 30);
+  EXPECT_EQ(trades[2].passiveId, 2);
+  EXPECT_EQ(trades[2].quantity, 10);
+}
+
 TEST_F(OrderBookTest, RestingOrderNoMatch) {
   book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
 
@@ -177,15 +202,23 @@ TEST_F(OrderBookTest, RestingOrderPartialThenFull) {
   EXPECT_EQ(trades[1].quantity, 30);
 }
 
+TEST_F(OrderBookTest, AcceptsTheLowestIdAndUser) {
+  NullSink sink;
+  const long long user = std::numeric_limits<long long>::min();
+  const int id = std::numeric_limits<int>::min();
+  book.addOrder(id, 100.0, 10, true, user, orderType::GTC, sink);
+  for (int i = 1; i <= 100; ++i) book.addOrder(i, 99.0, 10, true, i, orderType::GTC, sink);
+
+  EXPECT_EQ(book.cancelAllForUser(user, sink), 1);
+  EXPECT_EQ(book.restingOrderCount(), 100);
+  EXPECT_EQ(book.bestBid().price, Price(99.0));
+}
+
 // ============================================================================
 // Cancellation Tests
 // ============================================================================
 
-// NOTE: The current cancelOrder implementation has a known bug where it doesn't
-// properly remove orders from the book due to Order::operator< using timestamp.
-// These tests are marked as DISABLED to document expected behavior.
-
-TEST_F(OrderBookTest, DISABLED_CancelSingleOrder) {
+TEST_F(OrderBookTest, CancelSingleOrder) {
   book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
   book.cancelOrder(1);
 
@@ -211,7 +244,7 @@ TEST_F(OrderBookTest, CancelAndReaddSameId) {
   EXPECT_EQ(trades.size(), 0);
 }
 
-TEST_F(OrderBookTest, DISABLED_CancelPartiallyFilledOrder) {
+TEST_F(OrderBookTest, CancelPartiallyFilledOrder) {
   book.addOrder(1, 100.0, 50, false, 1001, orderType::GTC, trades);
   book.addOrder(2, 100.0, 20, true, 1002, orderType::GTC, trades);
 
@@ -224,6 +257,42 @@ TEST_F(OrderBookTest, DISABLED_CancelPartiallyFilledOrder) {
   EXPECT_EQ(trades.size(), 1);
 }
 
+TEST_F(OrderBookTest, CancelMiddleOfQueueKeepsFifo) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(3, 100.0, 10, false, 1003, orderType::GTC, trades);
+  book.cancelOrder(2);
+
+  book.addOrder(4, 100.0, 30, true, 1004, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 1);
+  EXPECT_EQ(trades[1].passiveId, 3);
+}
+
+TEST_F(OrderBookTest, CancelLastOrderAtLevelExposesNextLevel) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 101.0, 10, false, 1002, orderType::GTC, trades);
+  book.cancelOrder(1);
+
+  book.addOrder(3, 101.0, 10, true, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 2);
+  EXPECT_EQ(trades[0].price.to_double(), 101.0);
+}
+
+TEST_F(OrderBookTest, CancelFilledOrderIsNoOp) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::GTC, trades);
+  book.cancelOrder(1);
+  book.cancelOrder(2);
+
+  book.addOrder(3, 100.0, 10, true, 1003, orderType::GTC, trades);
+
+  EXPECT_EQ(trades.size(), 1);
+}
+
 TEST_F(OrderBookTest, CrossingTheSpreadBuy) {
   book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
     
@@ -315,6 +384,29 @@ TEST_F(OrderBookTest, FOKOrderMultipleLevels) {
   EXPECT_EQ(trades[1].quantity, 5);
 }
 
+TEST_F(OrderBookTest, FOKExcludesOwnRestingQuantity) {
+  book.setSelfTradePrevention(SelfTradePrevention::CancelOldest);
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 5, false, 1002, orderType::GTC, trades);
+
+  book.addOrder(3, 100.0, 10, true, 1001, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 0);
+
+  book.addOrder(4, 100.0, 5, true, 1001, orderType::FOK, trades);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 2);
+}
+
+TEST_F(OrderBookTest, FOKIgnoresOwnOrdersOutsideLimit) {
+  book.addOrder(1, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(2, 102.0, 10, false, 1001, orderType::GTC, trades);
+
+  book.addOrder(3, 100.0, 10, true, 1001, orderType::FOK, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 1);
+}
+
 TEST_F(OrderBookTest, ModifyOrder) {
   book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
     
@@ -327,6 +419,107 @@ TEST_F(OrderBookTest, ModifyOrder) {
   EXPECT_EQ(trades[0].price.to_double(), 101.0);
 }
 
+TEST_F(OrderBookTest, ModifyReduceKeepsPriority) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.modifyOrder(1, 100.0, 4, trades);
+
+  book.addOrder(3, 100.0, 6, true, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 1);
+  EXPECT_EQ(trades[0].quantity, 4);
+  EXPECT_EQ(trades[1].passiveId, 2);
+  EXPECT_EQ(trades[1].quantity, 2);
+}
+
+TEST_F(OrderBookTest, ModifyIncreaseLosesPriority) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.modifyOrder(1, 100.0, 15, trades);
+
+  book.addOrder(3, 100.0, 10, true, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 2);
+}
+
+TEST_F(OrderBookTest, ModifyRepriceLosesPriority) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.modifyOrder(1, 101.0, 10, trades);
+  book.modifyOrder(1, 100.0, 5, trades);
+
+  book.addOrder(3, 100.0, 10, true, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 2);
+}
+
+TEST_F(OrderBookTest, ModifyToZeroCancels) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.modifyOrder(1, 100.0, 0, trades);
+
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::GTC, trades);
+
+  EXPECT_EQ(trades.size(), 0);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST_F(OrderBookTest, ModifyUnknownOrderIsNoOp) {
+  book.modifyOrder(42, 100.0, 10, trades);
+
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
+
+  EXPECT_EQ(trades.size(), 0);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST_F(OrderBookTest, RestingOrderCountTracksFillsAndCancels) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 101.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(3, 102.0, 10, false, 1003, orderType::GTC, trades);
+  EXPECT_EQ(book.restingOrderCount(), 3);
+
+  book.addOrder(4, 100.0, 10, true, 1004, orderType::GTC, trades);
+  book.cancelOrder(2);
+
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST_F(OrderBookTest, TradesCarryInjectedClockTime) {
+  ManualClock clock(1000);
+  book.setClock(&clock);
+
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  clock.set(2500);
+  book.addOrder(2, 100.0, 4, true, 1002, orderType::GTC, trades);
+  clock.advance(10);
+  book.addOrder(3, 100.0, 4, true, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].timestamp, 2500);
+  EXPECT_EQ(trades[1].timestamp, 2510);
+}
+
+TEST_F(OrderBookTest, TimestampsAreZeroWithoutClock) {
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].timestamp, 0);
+}
+
+TEST_F(OrderBookTest, SequenceAdvancesPerAcceptedOrder) {
+  unsigned long long start = book.sequence();
+
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 99.0, 10, true, 1002, orderType::IOC, trades);
+
+  EXPECT_EQ(book.sequence(), start + 2);
+}
+
 TEST_F(OrderBookTest, MultipleSequentialTrades) {
   book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
   book.addOrder(2, 100.5, 10, false, 1002, orderType::GTC, trades);
@@ -350,6 +543,965 @@ TEST_F(OrderBookTest, StressTestManyOrders) {
   EXPECT_GT(trades.size(), 0);
 }
 
+// ============================================================================
+// Execution Sink Tests
+// ============================================================================
+
+class RecordingSink : public ExecutionSink {
+public:
+  std::vector<std::string> events;
+
+  void onAccepted(int id, Price, int quantity, bool, long long) override { record("accepted", id, quantity); }
+  void onTrade(const Trade& trade) override { record("trade", static_cast<int>(trade.passiveId), trade.quantity); }
+  void onRested(int id, Price, int quantity) override { record("rested", id, quantity); }
+  void onCancelled(int id, int quantity) override { record("cancelled", id, quantity); }
+  void onModified(int id, int newQuantity) override { record("modified", id, newQuantity); }
+
+private:
+  void record(const char* kind, int id, int quantity) {
+    events.push_back(std::string(kind) + " " + std::to_string(id) + " " + std::to_string(quantity));
+  }
+};
+
+TEST(ExecutionSinkTest, ReportsOrderLifecycle) {
+  OrderBook book;
+  RecordingSink sink;
+
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 100.0, 15, true, 1002, orderType::IOC, sink);
+  book.addOrder(3, 101.0, 5, true, 1003, orderType::GTC, sink);
+  book.modifyOrder(3, 101.0, 2, sink);
+  book.cancelOrder(3, sink);
+
+  std::vector<std::string> expected = {
+    "accepted 1 10", "rested 1 10",
+    "accepted 2 15", "trade 1 10", "cancelled 2 5",
+    "accepted 3 5", "rested 3 5",
+    "modified 3 2",
+    "cancelled 3 2",
+  };
+  EXPECT_EQ(sink.events, expected);
+}
+
+TEST(ExecutionSinkTest, SpecializedAddMatchesDispatchedAdd) {
+  OrderBook dispatched;
+  OrderBook specialized;
+  RecordingSink dispatchedSink;
+  RecordingSink specializedSink;
+
+  dispatched.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, dispatchedSink);
+  dispatched.addOrder(2, 99.0, 10, true, 1001, orderType::GTC, dispatchedSink);
+  dispatched.addOrder(3, 100.0, 4, true, 1002, orderType::IOC, dispatchedSink);
+  dispatched.addOrder(4, 99.0, 20, false, 1002, orderType::FOK, dispatchedSink);
+  dispatched.addOrder(5, 99.0, 6, false, 1002, orderType::FOK, dispatchedSink);
+  dispatched.addOrder(6, 98.0, 3, false, 1002, orderType::IOC, dispatchedSink);
+
+  specialized.addOrder<orderType::GTC, false>(1, 100.0, 10, 1001, specializedSink);
+  specialized.addOrder<orderType::GTC, true>(2, 99.0, 10, 1001, specializedSink);
+  specialized.addOrder<orderType::IOC, true>(3, 100.0, 4, 1002, specializedSink);
+  specialized.addOrder<orderType::FOK, false>(4, 99.0, 20, 1002, specializedSink);
+  specialized.addOrder<orderType::FOK, false>(5, 99.0, 6, 1002, specializedSink);
+  specialized.addOrder<orderType::IOC, false>(6, 98.0, 3, 1002, specializedSink);
+
+  EXPECT_EQ(specializedSink.events, dispatchedSink.events);
+  EXPECT_EQ(specialized.restingOrderCount(), 2);
+  EXPECT_EQ(specialized.bestBid().quantity, 1);
+  EXPECT_EQ(specialized.bestAsk().quantity, 6);
+}
+
+TEST(ExecutionSinkTest, ReportsKilledFOK) {
+  OrderBook book;
+  RecordingSink sink;
+
+  book.addOrder(1, 100.0, 5, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::FOK, sink);
+
+  ASSERT_EQ(sink.events.size(), 4);
+  EXPECT_EQ(sink.events[3], "cancelled 2 10");
+}
+
+TEST(ExecutionSinkTest, RepriceReportsCancelThenAccept) {
+  OrderBook book;
+  RecordingSink sink;
+
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, sink);
+  sink.events.clear();
+  book.modifyOrder(1, 99.0, 10, sink);
+
+  std::vector<std::string> expected = {"cancelled 1 10", "accepted 1 10", "rested 1 10"};
+  EXPECT_EQ(sink.events, expected);
+}
+
+// ============================================================================
+// Stop Order Tests
+// ============================================================================
+
+TEST(StopOrderTest, BuyStopFiresWhenTradeReachesStopPrice) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  TradeVectorSink sink(trades);
+  book.addOrder(1, 100.0, 5, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 101.0, 5, false, 1001, orderType::GTC, sink);
+  book.addOrder(3, 102.0, 5, false, 1001, orderType::GTC, sink);
+  book.addStopOrder(10, 101.0, 0.0, 7, true, 2001, orderType::STOP, sink);
+
+  book.addOrder(4, 100.0, 5, true, 1002, orderType::IOC, sink);
+  EXPECT_EQ(trades.size(), 1);
+  EXPECT_EQ(book.stopOrderCount(), 1);
+
+  book.addOrder(5, 101.0, 1, true, 1002, orderType::IOC, sink);
+  ASSERT_EQ(trades.size(), 4);
+  EXPECT_EQ(book.stopOrderCount(), 0);
+  EXPECT_EQ(trades[2].agressiveId, 10);
+  EXPECT_EQ(trades[2].price, Price(101.0));
+  EXPECT_EQ(trades[2].quantity, 4);
+  EXPECT_EQ(trades[3].agressiveId, 10);
+  EXPECT_EQ(trades[3].price, Price(102.0));
+  EXPECT_EQ(trades[3].quantity, 3);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST(StopOrderTest, FiredStopLimitRestsAtLimit) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 99.0, 5, true, 1001, orderType::GTC, sink);
+  book.addStopOrder(10, 99.0, 98.0, 3, false, 2001, orderType::STOP_LIMIT, sink);
+  book.addOrder(2, 99.0, 5, false, 1002, orderType::GTC, sink);
+
+  std::vector<std::string> expected = {
+    "accepted 1 5", "rested 1 5",
+    "accepted 10 3",
+    "accepted 2 5", "trade 1 5",
+    "accepted 10 3", "rested 10 3",
+  };
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.bestAsk().price, Price(98.0));
+}
+
+TEST(StopOrderTest, CascadeRunsWithoutRecursion) {
+  OrderBook book;
+  NullSink sink;
+  const int depth = 20000;
+  for (int i = 0; i < depth; ++i) {
+    book.addOrder(i, Price(static_cast<long long>(100000 - i)), 1, true, 1001, orderType::GTC, sink);
+    book.addStopOrder(depth + i, Price(static_cast<long long>(100000 - i)), 0.0, 1, false, 2001, orderType::STOP, sink);
+  }
+
+  // Each fired sell stop trades one tick lower and fires the next.
+  book.addOrder(2 * depth, Price(100000LL), 1, false, 1002, orderType::IOC, sink);
+  EXPECT_EQ(book.restingOrderCount(), 0);
+  EXPECT_EQ(book.stopOrderCount(), 0);
+}
+
+TEST(StopOrderTest, DormantStopCanBeCancelledButNotModified) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addStopOrder(10, 101.0, 101.5, 3, true, 2001, orderType::STOP_LIMIT, sink);
+  book.modifyOrder(10, 101.0, 1, sink);
+  book.addOrder(10, 100.0, 1, true, 2001, orderType::GTC, sink);
+  book.cancelOrder(10, sink);
+  book.cancelOrder(10, sink);
+
+  std::vector<std::string> expected = {"accepted 10 3", "cancelled 10 3"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.stopOrderCount(), 0);
+  EXPECT_EQ(book.restingOrderCount(), 0);
+}
+
+TEST(StopOrderTest, EntersAtOnceIfLastTradeIsAlreadyThrough) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  TradeVectorSink sink(trades);
+  book.addOrder(1, 100.0, 5, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 100.0, 1, true, 1002, orderType::GTC, sink);
+
+  book.apply(Command::stop(10, 99.0, 100.0, 2, true, 2001, orderType::STOP_LIMIT), sink);
+  EXPECT_EQ(book.stopOrderCount(), 0);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[1].agressiveId, 10);
+  EXPECT_EQ(trades[1].quantity, 2);
+
+  book.apply(Command::stop(11, 101.0, 0.0, 2, true, 2001), sink);
+  EXPECT_EQ(book.stopOrderCount(), 1);
+}
+
+// ============================================================================
+// Iceberg Order Tests
+// ============================================================================
+
+TEST(IcebergOrderTest, ShowsOneSliceAndRequeuesTheNextAtTheBack) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  TradeVectorSink sink(trades);
+  book.addIcebergOrder(1, 100.0, 30, 10, false, 1001, sink);
+  book.addOrder(2, 100.0, 5, false, 1002, orderType::GTC, sink);
+  EXPECT_EQ(book.bestAsk().quantity, 15);
+
+  book.addOrder(3, 100.0, 12, true, 2001, orderType::IOC, sink);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 1);
+  EXPECT_EQ(trades[0].quantity, 10);
+  EXPECT_EQ(trades[1].passiveId, 2);
+  EXPECT_EQ(trades[1].quantity, 2);
+  EXPECT_EQ(book.bestAsk().quantity, 13);
+  EXPECT_EQ(book.bestAsk().orderCount, 2);
+
+  trades.clear();
+  book.addOrder(4, 100.0, 8, true, 2001, orderType::IOC, sink);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 2);
+  EXPECT_EQ(trades[0].quantity, 3);
+  EXPECT_EQ(trades[1].passiveId, 1);
+  EXPECT_EQ(trades[1].quantity, 5);
+  EXPECT_EQ(book.bestAsk().quantity, 5);
+}
+
+TEST(IcebergOrderTest, OneAggressorCanDrainTheWholeReserve) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  TradeVectorSink sink(trades);
+  book.addIcebergOrder(1, 100.0, 25, 10, false, 1001, sink);
+
+  book.addOrder(2, 100.0, 40, true, 2001, orderType::GTC, sink);
+  ASSERT_EQ(trades.size(), 3);
+  EXPECT_EQ(trades[0].quantity, 10);
+  EXPECT_EQ(trades[1].quantity, 10);
+  EXPECT_EQ(trades[2].quantity, 5);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+  EXPECT_EQ(book.bestBid().quantity, 15);
+  EXPECT_EQ(book.bestAsk().orderCount, 0);
+}
+
+TEST(IcebergOrderTest, RestsAfterMatchingForFullQuantity) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 4, false, 1001, orderType::GTC, sink);
+  book.addIcebergOrder(2, 100.0, 20, 5, true, 2001, sink);
+
+  std::vector<std::string> expected = {
+    "accepted 1 4", "rested 1 4",
+    "accepted 2 20", "trade 1 4", "rested 2 16",
+  };
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.bestBid().quantity, 5);
+}
+
+TEST(IcebergOrderTest, FOKCountsHiddenReserve) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  NullSink sink;
+  book.addIcebergOrder(1, 100.0, 50, 10, false, 1001, sink);
+  book.addOrder(2, 100.0, 40, true, 2001, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 4);
+  book.addOrder(3, 100.0, 20, true, 2001, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 4);
+}
+
+TEST(IcebergOrderTest, AmendsGiveUpReserveFirstAndCancelReportsEverything) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 5, false, 1001, orderType::GTC, sink);
+  book.addIcebergOrder(2, 100.0, 30, 10, false, 1002, sink);
+
+  book.modifyOrder(2, 100.0, 15, sink);
+  EXPECT_EQ(book.bestAsk().quantity, 15);
+  book.modifyOrder(2, 100.0, 4, sink);
+  EXPECT_EQ(book.bestAsk().quantity, 9);
+
+  // Growing the order re-queues it, still as an iceberg.
+  book.modifyOrder(2, 100.0, 25, sink);
+  EXPECT_EQ(book.bestAsk().quantity, 15);
+  book.cancelOrder(2, sink);
+
+  std::vector<std::string> expected = {
+    "accepted 1 5", "rested 1 5",
+    "accepted 2 30", "rested 2 30",
+    "modified 2 15",
+    "modified 2 4",
+    "cancelled 2 4", "accepted 2 25", "rested 2 25",
+    "cancelled 2 25",
+  };
+  EXPECT_EQ(sink.events, expected);
+}
+
+TEST(IcebergOrderTest, DisplayQuantityIsIgnoredOnNonRestingCommands) {
+  OrderBook book;
+  RecordingSink sink;
+  book.apply(Command::add(1, 100.0, 5, false, 1001), sink);
+  Command ioc = Command::add(2, 100.0, 20, true, 1002, orderType::IOC);
+  ioc.displayQuantity = 5;
+  book.apply(ioc, sink);
+
+  std::vector<std::string> expected = {
+    "accepted 1 5", "rested 1 5",
+    "accepted 2 20", "trade 1 5", "cancelled 2 15",
+  };
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.restingOrderCount(), 0);
+}
+
+// ============================================================================
+// Self-Trade Prevention Tests
+// ============================================================================
+
+static std::vector<std::string> selfTradeEvents(SelfTradePrevention mode, int incoming) {
+  OrderBook book;
+  book.setSelfTradePrevention(mode);
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, sink);
+  sink.events.clear();
+  book.addOrder(3, 100.0, incoming, true, 1001, orderType::GTC, sink);
+  return sink.events;
+}
+
+TEST(SelfTradePreventionTest, CancelNewestIsTheDefaultAndKeepsTheRestingOrder) {
+  EXPECT_EQ(OrderBook().selfTradePrevention(), SelfTradePrevention::CancelNewest);
+  std::vector<std::string> expected = {"accepted 3 15", "cancelled 3 15"};
+  EXPECT_EQ(selfTradeEvents(SelfTradePrevention::CancelNewest, 15), expected);
+}
+
+TEST(SelfTradePreventionTest, CancelOldestRemovesOwnOrderAndKeepsMatching) {
+  std::vector<std::string> expected = {"accepted 3 15", "cancelled 1 10", "trade 2 10", "rested 3 5"};
+  EXPECT_EQ(selfTradeEvents(SelfTradePrevention::CancelOldest, 15), expected);
+}
+
+TEST(SelfTradePreventionTest, CancelBothRemovesBoth) {
+  std::vector<std::string> expected = {"accepted 3 15", "cancelled 1 10", "cancelled 3 15"};
+  EXPECT_EQ(selfTradeEvents(SelfTradePrevention::CancelBoth, 15), expected);
+}
+
+TEST(SelfTradePreventionTest, DecrementTakesTheSmallerQuantityFromBoth) {
+  std::vector<std::string> larger = {"accepted 3 15", "cancelled 1 10", "cancelled 3 10", "trade 2 5"};
+  EXPECT_EQ(selfTradeEvents(SelfTradePrevention::Decrement, 15), larger);
+  std::vector<std::string> smaller = {"accepted 3 4", "modified 1 6", "cancelled 3 4"};
+  EXPECT_EQ(selfTradeEvents(SelfTradePrevention::Decrement, 4), smaller);
+}
+
+TEST(SelfTradePreventionTest, FOKIsKilledWhenOwnOrderIsAhead) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  book.addOrder(1, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(3, 100.0, 10, false, 1002, orderType::GTC, trades);
+
+  book.addOrder(4, 100.0, 15, true, 1001, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 0);
+  book.addOrder(5, 100.0, 10, true, 1001, orderType::FOK, trades);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 1);
+  EXPECT_EQ(book.restingOrderCount(), 2);
+}
+
+TEST(SelfTradePreventionTest, FOKTracksTheOwnersBestPriceAsItsOrdersLeave) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  book.addOrder(1, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(3, 101.0, 10, false, 1001, orderType::GTC, trades);
+  book.cancelOrder(2);
+
+  book.addOrder(4, 100.0, 10, true, 1001, orderType::FOK, trades);
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 1);
+
+  book.addOrder(5, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(6, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(7, 100.0, 15, true, 1001, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 1);
+}
+
+// ============================================================================
+// Mass Cancel Tests
+// ============================================================================
+
+TEST(MassCancelTest, CancelsEveryOrderOfTheUserAndErasesEmptiedLevels) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, sink);
+  book.addOrder(2, 99.0, 10, true, 1002, orderType::GTC, sink);
+  book.addOrder(3, 98.0, 10, true, 1001, orderType::GTC, sink);
+  book.addIcebergOrder(4, 101.0, 30, 10, false, 1001, sink);
+  book.addOrder(5, 102.0, 10, false, 1002, orderType::GTC, sink);
+  sink.events.clear();
+
+  EXPECT_EQ(book.cancelAllForUser(1001, sink), 3);
+  std::vector<std::string> expected = {"cancelled 1 10", "cancelled 3 10", "cancelled 4 30"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.restingOrderCount(), 2);
+
+  DepthLevel levels[4];
+  ASSERT_EQ(book.depth(true, levels, 4), 1);
+  EXPECT_EQ(levels[0].quantity, 10);
+  EXPECT_EQ(book.bestAsk().price, Price(102.0));
+
+  EXPECT_EQ(book.cancelAllForUser(1001, sink), 0);
+  book.cancelOrder(1, sink);
+  EXPECT_EQ(sink.events.size(), 3);
+}
+
+TEST(MassCancelTest, FiltersBySideAndPriceRange) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, sink);
+  book.addOrder(2, 97.0, 10, true, 1001, orderType::GTC, sink);
+  book.addOrder(3, 101.0, 10, false, 1001, orderType::GTC, sink);
+  book.addOrder(4, 103.0, 10, false, 1001, orderType::GTC, sink);
+  sink.events.clear();
+
+  EXPECT_EQ(book.cancelOrdersForUser(1001, MassCancelFilter::side(false), sink), 2);
+  EXPECT_EQ(book.bestAsk().orderCount, 0);
+  EXPECT_EQ(book.bestBid().price, Price(99.0));
+
+  EXPECT_EQ(book.cancelOrdersForUser(1001, MassCancelFilter::priceRange(96.0, 98.0), sink), 1);
+  std::vector<std::string> expected = {"cancelled 3 10", "cancelled 4 10", "cancelled 2 10"};
+  EXPECT_EQ(sink.events, expected);
+
+  // The user's remaining order still trades and is still reachable by id.
+  std::vector<Trade> trades;
+  book.addOrder(5, 99.0, 4, false, 1002, orderType::IOC, trades);
+  ASSERT_EQ(trades.size(), 1);
+  book.cancelOrder(1, sink);
+  EXPECT_EQ(book.restingOrderCount(), 0);
+}
+
+TEST(MassCancelTest, KeepsTheDepthFeedInStep) {
+  OrderBook book;
+  DepthFeed feed;
+  book.setDepthFeed(&feed);
+  NullSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, sink);
+  book.addOrder(2, 100.0, 5, false, 1002, orderType::GTC, sink);
+  book.addOrder(3, 101.0, 10, false, 1001, orderType::GTC, sink);
+  feed.clear();
+
+  book.cancelAllForUser(1001, sink);
+  std::map<long long, int> levels;
+  feed.drain([&](const LevelDelta& delta) { levels[delta.price.value] = delta.quantity; });
+  EXPECT_EQ(levels[Price(100.0).value], 5);
+  EXPECT_EQ(levels[Price(101.0).value], 0);
+}
+
+// ============================================================================
+// Expiry Tests
+// ============================================================================
+
+TEST(ExpiryTest, GTDOrdersExpireOnceTheBookReachesTheirTime) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTD, 1000, sink);
+  book.addOrder(2, 100.0, 20, true, 1002, orderType::GTD, 2000, sink);
+  book.addOrder(3, 99.0, 30, true, 1003, orderType::GTC, sink);
+  EXPECT_EQ(book.expiringOrderCount(), 2);
+  sink.events.clear();
+
+  book.advanceTime(999, sink);
+  EXPECT_TRUE(sink.events.empty());
+  book.advanceTime(1000, sink);
+  book.advanceTime(1500, sink);
+  std::vector<std::string> expected = {"cancelled 1 10"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.bestBid().quantity, 20);
+
+  book.advanceTime(1000000, sink);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+  EXPECT_EQ(book.bestBid().price, Price(99.0));
+  EXPECT_EQ(book.expiringOrderCount(), 0);
+  EXPECT_EQ(book.currentTime(), 1000000);
+}
+
+TEST(ExpiryTest, DayOrdersExpireAtTheSessionClose) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::DAY, sink);
+  book.setSessionClose(5000);
+  book.addOrder(2, 101.0, 10, false, 1002, orderType::DAY, sink);
+  book.addOrder(3, 102.0, 10, false, 1003, orderType::DAY, 0, sink);
+  sink.events.clear();
+
+  book.advanceTime(5000, sink);
+  std::vector<std::string> expected = {"cancelled 2 10", "cancelled 3 10"};
+  EXPECT_EQ(sink.events, expected);
+  // Entered before a close was set, so it never expires.
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST(ExpiryTest, ExpiredOnArrivalIsCancelledWithoutMatching) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, sink);
+  book.advanceTime(1000, sink);
+  sink.events.clear();
+
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::GTD, 1000, sink);
+  std::vector<std::string> expected = {"accepted 2 10", "cancelled 2 10"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+}
+
+TEST(ExpiryTest, GTDWithoutADateIsRejected) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, sink);
+  sink.events.clear();
+
+  book.addOrder(2, 100.0, 10, true, 1002, orderType::GTD, sink);
+  book.apply(Command::add(3, 100.0, 10, true, 1002, orderType::GTD), sink);
+  std::vector<std::string> expected = {"accepted 2 10", "cancelled 2 10", "accepted 3 10", "cancelled 3 10"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+  EXPECT_EQ(book.expiringOrderCount(), 0);
+}
+
+TEST(ExpiryTest, FilledAndAmendedOrdersKeepTheWheelInStep) {
+  OrderBook book;
+  RecordingSink sink;
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTD, 1000, sink);
+  book.addOrder(2, 101.0, 10, false, 1001, orderType::GTD, 1000, sink);
+  book.addOrder(3, 100.0, 10, true, 1002, orderType::IOC, sink);
+  EXPECT_EQ(book.expiringOrderCount(), 1);
+
+  // A re-queueing amend keeps the expiry.
+  book.modifyOrder(2, 102.0, 20, sink);
+  EXPECT_EQ(book.expiringOrderCount(), 1);
+  sink.events.clear();
+  book.advanceTime(1000, sink);
+  std::vector<std::string> expected = {"cancelled 2 20"};
+  EXPECT_EQ(sink.events, expected);
+  EXPECT_EQ(book.restingOrderCount(), 0);
+}
+
+TEST(ExpiryTest, CommandsExpireOrdersByTheBookClock) {
+  OrderBook book;
+  ManualClock clock;
+  book.setClock(&clock);
+  NullSink sink;
+  book.apply(Command::goodTillDate(1, 100.0, 10, true, 1001, 1000), sink);
+  book.apply(Command::add(2, 99.0, 10, true, 1002, orderType::DAY), sink);
+
+  clock.set(1000);
+  book.apply(Command::advanceTime(1000), sink);
+  EXPECT_EQ(book.restingOrderCount(), 1);
+  EXPECT_EQ(book.currentTime(), 1000);
+}
+
+// Random expiries from a few ticks to years out, advanced in uneven steps,
+// so every wheel level and the overflow list take part; checked against a
+// plain sorted model.
+TEST(ExpiryTest, WheelMatchesASortedModel) {
+  OrderBook book;
+  std::mt19937_64 rng(11);
+  std::multimap<long long, int> model;
+  std::map<int, long long> expiryOf;
+  RecordingSink sink;
+  long long time = 0;
+  int nextId = 1;
+
+  for (int round = 0; round < 2000; ++round) {
+    for (int i = 0; i < 5; ++i) {
+      int digits = static_cast<int>(rng() % 18);
+      long long span = 1;
+      for (int d = 0; d < digits; ++d) span *= 10;
+      long long expiry = time + 1 + static_cast<long long>(rng() % span);
+      book.addOrder(nextId, 100.0, 1, true, 1001, orderType::GTD, expiry, sink);
+      model.emplace(expiry, nextId);
+      expiryOf[nextId] = expiry;
+      ++nextId;
+    }
+    if (round % 3 == 0 && !expiryOf.empty()) {
+      auto victim = expiryOf.begin();
+      std::advance(victim, rng() % expiryOf.size());
+      book.cancelOrder(victim->first);
+      auto range = model.equal_range(victim->second);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == victim->first) {
+          model.erase(it);
+          break;
+        }
+      }
+      expiryOf.erase(victim);
+    }
+
+    int digits = static_cast<int>(rng() % 17);
+    long long step = 1;
+    for (int d = 0; d < digits; ++d) step *= 10;
+    time += static_cast<long long>(rng() % step);
+    sink.events.clear();
+    book.advanceTime(time, sink);
+
+    std::set<int> expected;
+    while (!model.empty() && model.begin()->first <= time) {
+      expected.insert(model.begin()->second);
+      expiryOf.erase(model.begin()->second);
+      model.erase(model.begin());
+    }
+    std::set<int> expired;
+    for (const std::string& event : sink.events) expired.insert(std::stoi(event.substr(event.find(' ') + 1)));
+    ASSERT_EQ(expired, expected) << "round " << round;
+    ASSERT_EQ(book.expiringOrderCount(), model.size());
+  }
+}
+
+// ============================================================================
+// Ladder Mode Tests
+// ============================================================================
+
+class LadderOrderBookTest : public ::testing::Test {
+protected:
+  OrderBook book{LadderConfig{90.0, 110.0, 5}};
+  std::vector<Trade> trades;
+};
+
+TEST_F(LadderOrderBookTest, SweepsLevelsInPriceOrder) {
+  book.addOrder(1, 101.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(3, 102.0, 10, false, 1003, orderType::GTC, trades);
+
+  book.addOrder(4, 101.5, 30, true, 1004, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 2);
+  EXPECT_EQ(trades[1].passiveId, 1);
+}
+
+TEST_F(LadderOrderBookTest, MergesOutOfBandLevels) {
+  book.addOrder(1, 120.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 10, false, 1002, orderType::GTC, trades);
+  book.addOrder(3, 85.0, 10, false, 1003, orderType::GTC, trades);
+
+  book.addOrder(4, 130.0, 30, true, 1004, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 3);
+  EXPECT_EQ(trades[0].price.to_double(), 85.0);
+  EXPECT_EQ(trades[1].price.to_double(), 100.0);
+  EXPECT_EQ(trades[2].price.to_double(), 120.0);
+}
+
+TEST_F(LadderOrderBookTest, OffTickPriceFallsBackToTree) {
+  book.addOrder(1, 100.02, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.05, 10, true, 1002, orderType::GTC, trades);
+  book.addOrder(3, 99.95, 10, true, 1003, orderType::GTC, trades);
+
+  book.addOrder(4, 99.0, 30, false, 1004, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 3);
+  EXPECT_EQ(trades[0].passiveId, 2);
+  EXPECT_EQ(trades[1].passiveId, 1);
+  EXPECT_EQ(trades[2].passiveId, 3);
+}
+
+TEST_F(LadderOrderBookTest, CancelBestLevelExposesNextLevel) {
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 95.0, 10, true, 1002, orderType::GTC, trades);
+  book.cancelOrder(1);
+
+  book.addOrder(3, 90.0, 10, false, 1003, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 1);
+  EXPECT_EQ(trades[0].passiveId, 2);
+  EXPECT_EQ(trades[0].price.to_double(), 95.0);
+}
+
+TEST_F(LadderOrderBookTest, FOKUsesLadderLevels) {
+  book.addOrder(1, 100.0, 5, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.5, 5, false, 1002, orderType::GTC, trades);
+
+  book.addOrder(3, 100.5, 11, true, 1003, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 0);
+
+  book.addOrder(4, 100.5, 10, true, 1004, orderType::FOK, trades);
+  EXPECT_EQ(trades.size(), 2);
+}
+
+TEST(LadderConfigTest, RejectsInvalidBand) {
+  EXPECT_THROW(OrderBook(LadderConfig{110.0, 90.0, 1}), std::invalid_argument);
+  EXPECT_THROW(OrderBook(LadderConfig{90.0, 110.0, 0}), std::invalid_argument);
+}
+
+TEST(DepthTest, AggregatesTopLevelsBestFirst) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 99.0, 5, true, 1002, orderType::GTC, trades);
+  book.addOrder(3, 98.0, 7, true, 1003, orderType::GTC, trades);
+  book.addOrder(4, 97.0, 1, true, 1004, orderType::GTC, trades);
+  book.addOrder(5, 101.0, 3, false, 1005, orderType::GTC, trades);
+
+  DepthLevel levels[2];
+  ASSERT_EQ(book.depth(true, levels, 2), 2);
+  EXPECT_EQ(levels[0].price.to_double(), 99.0);
+  EXPECT_EQ(levels[0].quantity, 15);
+  EXPECT_EQ(levels[0].orderCount, 2);
+  EXPECT_EQ(levels[1].price.to_double(), 98.0);
+
+  ASSERT_EQ(book.depth(false, levels, 2), 1);
+  EXPECT_EQ(levels[0].quantity, 3);
+}
+
+TEST(DepthFeedTest, ConflatesChangesPerLevel) {
+  OrderBook book;
+  DepthFeed feed(16);
+  book.setDepthFeed(&feed);
+  std::vector<Trade> trades;
+
+  book.addOrder(1, 100.0, 10, false, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 5, false, 1002, orderType::GTC, trades);
+  book.addOrder(3, 101.0, 5, false, 1003, orderType::GTC, trades);
+  ASSERT_EQ(feed.size(), 2);
+  EXPECT_EQ(feed.begin()[0].quantity, 15);
+  EXPECT_EQ(feed.begin()[0].orderCount, 2);
+  EXPECT_EQ(feed.begin()[1].price.to_double(), 101.0);
+  feed.clear();
+
+  // One sweep: 100.00 is deleted and 101.00 partially filled.
+  book.addOrder(4, 101.0, 17, true, 1004, orderType::IOC, trades);
+  std::vector<LevelDelta> deltas;
+  EXPECT_EQ(feed.drain([&](const LevelDelta& delta) { deltas.push_back(delta); }), 2);
+  EXPECT_EQ(deltas[0].price.to_double(), 100.0);
+  EXPECT_EQ(deltas[0].quantity, 0);
+  EXPECT_FALSE(deltas[0].isBuy);
+  EXPECT_EQ(deltas[1].quantity, 3);
+  EXPECT_EQ(feed.size(), 0);
+
+  book.modifyOrder(3, 101.0, 1, trades);
+  book.cancelOrder(3);
+  ASSERT_EQ(feed.size(), 1);
+  EXPECT_EQ(feed.begin()[0].quantity, 0);
+}
+
+TEST(DepthFeedTest, UnconflatedFeedKeepsEveryChange) {
+  OrderBook book;
+  DepthFeed feed(16, false);
+  book.setDepthFeed(&feed);
+  std::vector<Trade> trades;
+
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 5, true, 1002, orderType::GTC, trades);
+  book.cancelOrder(1);
+  ASSERT_EQ(feed.size(), 3);
+  EXPECT_EQ(feed.begin()[0].quantity, 10);
+  EXPECT_EQ(feed.begin()[1].quantity, 15);
+  EXPECT_EQ(feed.begin()[2].quantity, 5);
+}
+
+TEST(DepthFeedTest, FlagsOverflow) {
+  OrderBook book;
+  DepthFeed feed(2);
+  book.setDepthFeed(&feed);
+  std::vector<Trade> trades;
+
+  for (int i = 0; i < 3; ++i) book.addOrder(i, 100.0 + i, 1, false, 1001, orderType::GTC, trades);
+  EXPECT_EQ(feed.size(), 2);
+  EXPECT_TRUE(feed.overflowed());
+  book.addOrder(10, 100.0, 1, false, 1001, orderType::GTC, trades);  // still conflates into a kept level
+  EXPECT_EQ(feed.begin()[0].quantity, 2);
+  feed.clear();
+  EXPECT_FALSE(feed.overflowed());
+}
+
+TEST(DepthFeedTest, DeltasRebuildTheBook) {
+  OrderBook book;
+  DepthFeed feed(1024);
+  book.setDepthFeed(&feed);
+  std::map<std::pair<bool, long long>, long long> mirror;
+  std::mt19937 gen(11);
+  std::vector<Trade> trades;
+
+  for (int i = 0; i < 5000; ++i) {
+    int action = gen() % 4;
+    if (action == 0) book.cancelOrder(gen() % (i + 1));
+    else if (action == 1) book.modifyOrder(gen() % (i + 1), Price(10000LL + static_cast<int>(gen() % 21) - 10), 1 + gen() % 20, trades);
+    else book.addOrder(i, Price(10000LL + static_cast<int>(gen() % 21) - 10), 1 + gen() % 20, gen() % 2 == 0, gen() % 30, orderType::GTC, trades);
+
+    if (i % 7 == 0) {
+      feed.drain([&](const LevelDelta& delta) {
+        if (delta.quantity == 0) mirror.erase({delta.isBuy, delta.price.value});
+        else mirror[{delta.isBuy, delta.price.value}] = delta.quantity;
+      });
+    }
+  }
+  ASSERT_FALSE(feed.overflowed());
+  feed.drain([&](const LevelDelta& delta) {
+    if (delta.quantity == 0) mirror.erase({delta.isBuy, delta.price.value});
+    else mirror[{delta.isBuy, delta.price.value}] = delta.quantity;
+  });
+
+  DepthLevel levels[64];
+  size_t bids = book.depth(true, levels, 64);
+  size_t asks = book.depth(false, levels + bids, 64 - bids);
+  ASSERT_EQ(mirror.size(), bids + asks);
+  for (size_t i = 0; i < bids + asks; ++i) {
+    auto it = mirror.find({i < bids, levels[i].price.value});
+    ASSERT_NE(it, mirror.end());
+    EXPECT_EQ(it->second, levels[i].quantity);
+  }
+}
+
+TEST(TopOfBookTest, TracksBestLevelsThroughBookChanges) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  EXPECT_EQ(book.bestBid().orderCount, 0);
+  EXPECT_EQ(book.spread().value, 0);
+
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 99.0, 5, true, 1002, orderType::GTC, trades);
+  book.addOrder(3, 98.0, 7, true, 1003, orderType::GTC, trades);
+  book.addOrder(4, 101.0, 3, false, 1004, orderType::GTC, trades);
+  EXPECT_EQ(book.bestBid().price.to_double(), 99.0);
+  EXPECT_EQ(book.bestBid().quantity, 15);
+  EXPECT_EQ(book.bestBid().orderCount, 2);
+  EXPECT_EQ(book.bestAsk().quantity, 3);
+  EXPECT_EQ(book.spread().value, 200);
+
+  book.addOrder(5, 99.0, 12, false, 1005, orderType::IOC, trades);
+  EXPECT_EQ(book.bestBid().quantity, 3);
+  EXPECT_EQ(book.bestBid().orderCount, 1);
+
+  book.modifyOrder(2, 99.0, 1, trades);
+  EXPECT_EQ(book.bestBid().quantity, 1);
+
+  book.cancelOrder(2);
+  EXPECT_EQ(book.bestBid().price.to_double(), 98.0);
+  book.cancelOrder(4);
+  EXPECT_EQ(book.bestAsk().orderCount, 0);
+  EXPECT_EQ(book.spread().value, 0);
+}
+
+TEST(TopOfBookTest, VersionAdvancesOnlyWhenTopChanges) {
+  OrderBook book;
+  std::vector<Trade> trades;
+  const Seqlock<TopOfBook>& feed = book.topOfBook();
+
+  book.addOrder(1, 99.0, 10, true, 1001, orderType::GTC, trades);
+  unsigned long long version = feed.version();
+  EXPECT_GT(version, 0);
+
+  book.addOrder(2, 98.0, 10, true, 1002, orderType::GTC, trades);
+  book.addOrder(3, 101.0, 10, true, 1003, orderType::GTC, trades);  // crosses nothing: rests as best bid
+  EXPECT_EQ(feed.version(), version + 1);
+  book.cancelOrder(2);
+  EXPECT_EQ(feed.version(), version + 1);
+
+  unsigned long long seen = 0;
+  TopOfBook top = feed.load(&seen);
+  EXPECT_EQ(seen, version + 1);
+  EXPECT_EQ(top.bid.price.to_double(), 101.0);
+  EXPECT_EQ(top.ask.orderCount, 0);
+}
+
+TEST(TopOfBookTest, ReadersOnOtherThreadsNeverSeeTornValues) {
+  OrderBook book;
+  std::atomic<bool> done{false};
+  std::atomic<long long> torn{0};
+
+  // Each state has quantity == price - 9000 on the bid, so a mixed read shows.
+  std::thread reader([&] {
+    while (!done.load()) {
+      TopOfBook top = book.topOfBook().load();
+      if (top.bid.orderCount && top.bid.quantity != top.bid.price.value - 9000) ++torn;
+    }
+  });
+
+  std::vector<Trade> trades;
+  for (int i = 0; i < 20000; ++i) {
+    long long price = 9001 + i % 500;
+    book.addOrder(i, Price(price), static_cast<int>(price - 9000), true, 1001, orderType::GTC, trades);
+    book.cancelOrder(i);
+  }
+  done = true;
+  reader.join();
+  EXPECT_EQ(torn.load(), 0);
+}
+
+// Returns 1000, 2000, ... and counts how often it was read.
+class CountingClock : public Clock {
+public:
+  int reads = 0;
+  long long now() override { return ++reads * 1000LL; }
+};
+
+static std::vector<Command> batchCommands() {
+  std::mt19937 gen(5);
+  std::vector<Command> commands;
+  for (int i = 0; i < 2000; ++i) {
+    int action = gen() % 4;
+    if (action == 0) commands.push_back(Command::cancel(gen() % (i + 1)));
+    else if (action == 1) commands.push_back(Command::modify(gen() % (i + 1), Price(10000LL + static_cast<int>(gen() % 11) - 5), 1 + gen() % 20));
+    else commands.push_back(Command::add(i, Price(10000LL + static_cast<int>(gen() % 11) - 5), 1 + gen() % 20, gen() % 2 == 0, gen() % 30,
+                                         gen() % 5 == 0 ? orderType::IOC : orderType::GTC));
+  }
+  return commands;
+}
+
+TEST(ApplyBatchTest, MatchesCommandByCommandApply) {
+  std::vector<Command> commands = batchCommands();
+
+  OrderBook single;
+  std::vector<ExecutionReport> expected;
+  ReportSink<AppendReports> singleSink(AppendReports{&expected});
+  for (const Command& command : commands) single.apply(command, singleSink);
+
+  OrderBook batched;
+  std::vector<ExecutionReport> actual;
+  actual.reserve(expected.size());
+  ReportSink<AppendReports> batchSink(AppendReports{&actual});
+  for (size_t i = 0; i < commands.size(); i += 64) {
+    batched.applyBatch(commands.data() + i, std::min<size_t>(64, commands.size() - i), batchSink);
+  }
+
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(actual[i].type, expected[i].type);
+    EXPECT_EQ(actual[i].id, expected[i].id);
+    EXPECT_EQ(actual[i].contraId, expected[i].contraId);
+    EXPECT_EQ(actual[i].quantity, expected[i].quantity);
+  }
+  EXPECT_EQ(batched.restingOrderCount(), single.restingOrderCount());
+}
+
+TEST(ApplyBatchTest, ReadsTheClockOncePerBatch) {
+  OrderBook book;
+  CountingClock clock;
+  book.setClock(&clock);
+  std::vector<Trade> trades;
+  TradeVectorSink sink(trades);
+
+  Command batch[] = {
+    Command::add(1, 100.0, 5, false, 1001),
+    Command::add(2, 100.0, 5, false, 1002),
+    Command::add(3, 100.0, 10, true, 1003),
+  };
+  book.applyBatch(batch, 3, sink);
+  EXPECT_EQ(clock.reads, 1);
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].timestamp, 1000);
+  EXPECT_EQ(trades[1].timestamp, 1000);
+
+  // Outside a batch the clock is read per order again.
+  book.addOrder(4, 100.0, 1, false, 1004, orderType::GTC, trades);
+  EXPECT_EQ(clock.reads, 2);
+}
+
+TEST(ApplyBatchTest, ThrowingCommandEndsTheBatch) {
+  struct ThrowingSink : ExecutionSink {
+    void onTrade(const Trade&) override { throw std::runtime_error("sink failed"); }
+  };
+  OrderBook book;
+  CountingClock clock;
+  book.setClock(&clock);
+  ThrowingSink sink;
+
+  Command batch[] = {
+    Command::add(1, 100.0, 5, false, 1001),
+    Command::add(2, 100.0, 5, true, 1002),
+  };
+  EXPECT_THROW(book.applyBatch(batch, 2, sink), std::runtime_error);
+  EXPECT_EQ(clock.reads, 1);
+  NullSink quiet;
+  book.addOrder(3, 99.0, 1, false, 1003, orderType::GTC, quiet);
+  EXPECT_EQ(clock.reads, 2);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include "FlatMap.h"
+#include "Order.h"
+#include "OrderIndex.h"
+#include <limits>
+#include <vector>
+
+TEST(OrderIndexTest, InsertFindErase) {
+  OrderIndex index;
+  Order order(7, 10, 1001, true, nullptr);
+
+  EXPECT_TRUE(index.insert(7, &order));
+  EXPECT_FALSE(index.insert(7, &order));
+  EXPECT_EQ(index.find(7), &order);
+  EXPECT_EQ(index.find(8), nullptr);
+
+  EXPECT_EQ(index.erase(7), &order);
+  EXPECT_EQ(index.erase(7), nullptr);
+  EXPECT_TRUE(index.empty());
+}
+
+TEST(OrderIndexTest, EraseKeepsProbeChainsIntact) {
+  OrderIndex index(16);
+  std::vector<Order> nodes;
+  nodes.reserve(1000);
+  for (int i = 0; i < 1000; ++i) {
+    nodes.emplace_back(i, 1, 0, true, nullptr);
+    index.insert(i, &nodes.back());
+  }
+  for (int i = 0; i < 1000; i += 2) index.erase(i);
+
+  EXPECT_EQ(index.size(), 500);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(index.find(i), i % 2 ? &nodes[i] : nullptr);
+  }
+}
+
+TEST(FlatMapTest, FindOrInsertAndErase) {
+  FlatMap<long long, int> map;
+  bool inserted;
+
+  map.findOrInsert(1LL << 40, inserted) = 5;
+  EXPECT_TRUE(inserted);
+  map.findOrInsert(1LL << 40, inserted) += 1;
+  EXPECT_FALSE(inserted);
+  ASSERT_NE(map.find(1LL << 40), nullptr);
+  EXPECT_EQ(*map.find(1LL << 40), 6);
+
+  int removed = 0;
+  EXPECT_TRUE(map.erase(1LL << 40, &removed));
+  EXPECT_EQ(removed, 6);
+  EXPECT_FALSE(map.erase(1LL << 40));
+  EXPECT_EQ(map.find(1LL << 40), nullptr);
+}
+
+TEST(FlatMapTest, StoresTheEmptyKeyBesideTheTable) {
+  FlatMap<long long, int> map;
+  const long long sentinel = std::numeric_limits<long long>::min();
+  map[sentinel] = 7;
+  for (long long key = 0; key < 100; ++key) map[key] = 1;
+
+  ASSERT_NE(map.find(sentinel), nullptr);
+  EXPECT_EQ(*map.find(sentinel), 7);
+  EXPECT_EQ(map.size(), 101);
+  int visited = 0;
+  map.forEach([&](long long key, int) { visited += key == sentinel; });
+  EXPECT_EQ(visited, 1);
+
+  EXPECT_TRUE(map.erase(sentinel));
+  EXPECT_EQ(map.find(sentinel), nullptr);
+  EXPECT_EQ(map.size(), 100);
+}
+
+TEST(FlatMapTest, FindAtOnlyLooksInTheGivenSlot) {
+  FlatMap<long long, int> map;
+  EXPECT_EQ(map.prefetch(1), (FlatMap<long long, int>::NoSlot));
+  EXPECT_EQ(map.findAt(FlatMap<long long, int>::NoSlot, 1), nullptr);
+
+  map[1] = 5;
+  size_t slot = map.prefetch(1);
+  ASSERT_NE(map.findAt(slot, 1), nullptr);
+  EXPECT_EQ(*map.findAt(slot, 1), 5);
+  EXPECT_EQ(map.findAt(slot, 2), nullptr);
+
+  for (long long key = 2; key < 100; ++key) map[key] = 1;
+  const int* moved = map.findAt(slot, 1);
+  EXPECT_TRUE(moved == nullptr || *moved == 5);
+  map.erase(1);
+  EXPECT_EQ(map.findAt(map.prefetch(1), 1), nullptr);
+}
@@ -0,0 +1,237 @@
+#include <gtest/gtest.h>
+#include "Journal.h"
+#include "MatchingThread.h"
+#include "OrderBook.h"
+#include "Snapshot.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+static void restAll(OrderBook& book) {
+  std::vector<Trade> trades;
+  book.addOrder(1, 100.0, 10, true, 1001, orderType::GTC, trades);
+  book.addOrder(2, 100.0, 20, true, 1002, orderType::GTC, trades);
+  book.addOrder(3, 99.5, 30, true, 1001, orderType::GTC, trades);
+  book.addOrder(4, 101.0, 15, false, 1003, orderType::GTC, trades);
+  book.addOrder(5, 101.0, 25, false, 1004, orderType::GTC, trades);
+  book.addOrder(6, 102.0, 35, false, 1003, orderType::GTC, trades);
+  book.addOrder(7, 250.0, 5, false, 1005, orderType::GTC, trades);  // outside the ladder band
+}
+
+static std::vector<Trade> sweep(OrderBook& book) {
+  std::vector<Trade> trades;
+  book.addOrder(100, 300.0, 1000, true, 2000, orderType::IOC, trades);
+  book.addOrder(101, 1.0, 1000, false, 2000, orderType::IOC, trades);
+  return trades;
+}
+
+static void expectSameTrades(const std::vector<Trade>& a, const std::vector<Trade>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_EQ(a[i].passiveId, b[i].passiveId);
+    EXPECT_EQ(a[i].agressiveId, b[i].agressiveId);
+    EXPECT_EQ(a[i].price, b[i].price);
+    EXPECT_EQ(a[i].quantity, b[i].quantity);
+  }
+}
+
+TEST(SnapshotTest, RestorePreservesPriorityAndSequence) {
+  OrderBook original;
+  restAll(original);
+  std::vector<char> image;
+  original.saveSnapshot(image, 42);
+  EXPECT_EQ(image.size(), sizeof(SnapshotHeader) + 5 * sizeof(SnapshotLevel) + 7 * sizeof(SnapshotOrder));
+
+  OrderBook restored;
+  EXPECT_EQ(restored.restoreSnapshot(image.data(), image.size()), 42);
+  EXPECT_EQ(restored.restingOrderCount(), 7);
+  EXPECT_EQ(restored.sequence(), original.sequence());
+
+  std::vector<char> again;
+  restored.saveSnapshot(again, 42);
+  EXPECT_EQ(again, image);
+
+  expectSameTrades(sweep(original), sweep(restored));
+  EXPECT_EQ(restored.restingOrderCount(), 0);
+}
+
+TEST(SnapshotTest, RestoresIntoLadderBook) {
+  OrderBook original;
+  restAll(original);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook restored{LadderConfig{90.0, 110.0, 5}};
+  restored.restoreSnapshot(image.data(), image.size());
+  expectSameTrades(sweep(original), sweep(restored));
+}
+
+TEST(SnapshotTest, RestoredOrdersCanBeCancelledAndModified) {
+  OrderBook original;
+  restAll(original);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook restored;
+  restored.restoreSnapshot(image.data(), image.size());
+  restored.cancelOrder(1);
+  std::vector<Trade> trades;
+  restored.modifyOrder(4, 101.0, 5, trades);
+  restored.addOrder(8, 101.0, 10, true, 1001, orderType::GTC, trades);
+
+  ASSERT_EQ(trades.size(), 2);
+  EXPECT_EQ(trades[0].passiveId, 4);
+  EXPECT_EQ(trades[0].quantity, 5);
+  EXPECT_EQ(trades[1].passiveId, 5);
+  EXPECT_EQ(restored.restingOrderCount(), 5);
+}
+
+TEST(SnapshotTest, DormantStopsSurviveRestore) {
+  OrderBook original;
+  restAll(original);
+  NullSink sink;
+  std::vector<Trade> trades;
+  original.addOrder(8, 101.0, 1, true, 2000, orderType::IOC, trades);
+  original.addStopOrder(20, 102.0, 0.0, 30, true, 2001, orderType::STOP, sink);
+  original.addStopOrder(21, 100.0, 99.0, 10, false, 2002, orderType::STOP_LIMIT, sink);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook restored;
+  restored.restoreSnapshot(image.data(), image.size());
+  EXPECT_EQ(restored.stopOrderCount(), 2);
+  std::vector<char> again;
+  restored.saveSnapshot(again);
+  EXPECT_EQ(again, image);
+
+  expectSameTrades(sweep(original), sweep(restored));
+  EXPECT_EQ(restored.stopOrderCount(), 0);
+  EXPECT_EQ(restored.restingOrderCount(), original.restingOrderCount());
+}
+
+TEST(SnapshotTest, IcebergReservesSurviveRestore) {
+  OrderBook original;
+  restAll(original);
+  NullSink sink;
+  original.addIcebergOrder(30, 101.0, 100, 10, false, 1006, sink);
+  original.addIcebergOrder(31, 99.5, 60, 25, true, 1007, sink);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook restored;
+  restored.restoreSnapshot(image.data(), image.size());
+  EXPECT_EQ(restored.bestAsk().quantity, original.bestAsk().quantity);
+  expectSameTrades(sweep(original), sweep(restored));
+  EXPECT_EQ(restored.restingOrderCount(), 0);
+}
+
+TEST(SnapshotTest, ExpiriesSurviveRestore) {
+  OrderBook original;
+  original.setSessionClose(5000);
+  original.advanceTime(100);
+  NullSink sink;
+  original.addOrder(1, 100.0, 10, true, 1001, orderType::GTD, 1000, sink);
+  original.addOrder(2, 101.0, 10, false, 1002, orderType::DAY, 0, sink);
+  original.addOrder(3, 99.0, 10, true, 1003, orderType::GTC, sink);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook restored;
+  restored.restoreSnapshot(image.data(), image.size());
+  EXPECT_EQ(restored.currentTime(), 100);
+  EXPECT_EQ(restored.sessionCloseTime(), 5000);
+  EXPECT_EQ(restored.expiringOrderCount(), 2);
+
+  restored.advanceTime(1000);
+  EXPECT_EQ(restored.restingOrderCount(), 2);
+  EXPECT_EQ(restored.bestBid().price, Price(99.0));
+  restored.advanceTime(5000);
+  EXPECT_EQ(restored.restingOrderCount(), 1);
+  EXPECT_EQ(restored.expiringOrderCount(), 0);
+}
+
+TEST(SnapshotTest, RejectsBadInput) {
+  OrderBook original;
+  restAll(original);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+
+  OrderBook busy;
+  std::vector<Trade> trades;
+  busy.addOrder(1, 100.0, 1, true, 1, orderType::GTC, trades);
+  EXPECT_THROW(busy.restoreSnapshot(image.data(), image.size()), std::invalid_argument);
+
+  OrderBook truncated;
+  EXPECT_THROW(truncated.restoreSnapshot(image.data(), image.size() - 1), std::invalid_argument);
+
+  std::vector<char> garbage(image.size(), 'x');
+  OrderBook foreign;
+  EXPECT_THROW(foreign.restoreSnapshot(garbage.data(), garbage.size()), std::invalid_argument);
+}
+
+TEST(SnapshotTest, RejectsIcebergsThatCannotReplenish) {
+  OrderBook original;
+  NullSink sink;
+  original.addIcebergOrder(1, 100.0, 100, 10, false, 1001, sink);
+  std::vector<char> image;
+  original.saveSnapshot(image);
+  size_t entry = sizeof(SnapshotHeader) + sizeof(SnapshotLevel);
+
+  std::vector<char> noSlice = image;
+  int zero = 0;
+  std::memcpy(noSlice.data() + entry + offsetof(SnapshotOrder, displayQuantity), &zero, sizeof(zero));
+  OrderBook first;
+  EXPECT_THROW(first.restoreSnapshot(noSlice.data(), noSlice.size()), std::invalid_argument);
+
+  std::vector<char> oversized = image;
+  int visible = 11;
+  std::memcpy(oversized.data() + entry + offsetof(SnapshotOrder, quantity), &visible, sizeof(visible));
+  OrderBook second;
+  EXPECT_THROW(second.restoreSnapshot(oversized.data(), oversized.size()), std::invalid_argument);
+}
+
+TEST(SnapshotTest, SnapshotPlusJournalTailRecoversLiveBook) {
+  std::string path = ::testing::TempDir() + "snapshot-tail.journal";
+  std::mt19937 gen(3);
+  std::vector<char> image;
+  std::vector<char> live;
+  {
+    JournalWriter writer(path);
+    MatchingThread engine(MatchingThread::Config{});
+    engine.setJournal(&writer);
+    engine.start();
+
+    ExecutionReport report;
+    for (int i = 0; i < 4000; ++i) {
+      if (i == 2000) {
+        while (engine.processed() < 2000) std::this_thread::yield();
+        ASSERT_TRUE(engine.snapshot(0, image));
+      }
+      Command command = i % 5 == 4 ? Command::cancel(gen() % i)
+                                   : Command::add(i, Price(10000LL + static_cast<int>(gen() % 21) - 10), 1 + gen() % 20, gen() % 2 == 0, gen() % 50);
+      command.timestamp = i;
+      while (!engine.submit(0, command)) {
+        while (engine.poll(report)) {}
+      }
+      while (engine.poll(report)) {}
+    }
+    engine.stop();
+    engine.book().saveSnapshot(live);
+  }
+
+  OrderBook recovered;
+  unsigned long long resumeAfter = recovered.restoreSnapshot(image.data(), image.size());
+  EXPECT_EQ(resumeAfter, 2000);
+  NullSink sink;
+  JournalReader reader(path);
+  EXPECT_EQ(replayJournal(reader, recovered, sink, resumeAfter), reader.size() - resumeAfter);
+
+  std::vector<char> rebuilt;
+  recovered.saveSnapshot(rebuilt);
+  EXPECT_EQ(rebuilt, live);
+  std::remove(path.c_str());
+}